@@ -8,6 +8,14 @@ public:
     BouncingBallsScene() : Scene("Bouncing Balls Demo") {}
     
     void OnLoad() override {
+        // Static walls around the screen; balls bounce off them and fall
+        // asleep once they come to rest on the floor
+        CreateWall({400, -50}, {1000, 100});
+        CreateWall({400, 650}, {1000, 100});
+        CreateWall({-50, 300}, {100, 600});
+        CreateWall({850, 300}, {100, 600});
+        PhysicsWorld::SetFriction(0.2f);  // Lets balls stop rolling along the floor
+        
         // Create some bouncing balls
         for (int i = 0; i < 10; i++) {
             auto ball = CreateGameObject("Ball");
@@ -30,10 +38,10 @@ public:
             
             // Add physics
             auto rb = ball->AddComponent<Rigidbody>();
-            rb->velocity = {Random(-200.0f, 200.0f), Random(-200.0f, 200.0f)};
-            rb->drag = 1.0f;  // No drag
-            rb->useGravity = true;
-            rb->gravity = 300.0f;
+            rb->SetVelocity({Random(-200.0f, 200.0f), Random(-200.0f, 200.0f)});
+            rb->SetDrag(1.0f);  // No drag
+            rb->SetUseGravity(true);
+            rb->SetGravity(300.0f);
             
             auto collider = ball->AddComponent<CircleCollider>(16.0f);
             
@@ -53,37 +61,6 @@ public:
         }
     }
     
-    void Update() override {
-        Scene::Update();
-        
-        // Keep balls in bounds (bounce off walls)
-        for (auto& obj : GetAllGameObjects()) {
-            auto rb = obj->GetComponent<Rigidbody>();
-            if (!rb) continue;
-            
-            Vector2& pos = obj->transform->position;
-            Vector2& vel = rb->velocity;
-            
-            float radius = 16;
-            if (pos.x - radius < 0) {
-                pos.x = radius;
-                vel.x = -vel.x * 0.8f;
-            }
-            if (pos.x + radius > 800) {
-                pos.x = 800 - radius;
-                vel.x = -vel.x * 0.8f;
-            }
-            if (pos.y - radius < 0) {
-                pos.y = radius;
-                vel.y = -vel.y * 0.8f;
-            }
-            if (pos.y + radius > 600) {
-                pos.y = 600 - radius;
-                vel.y = -vel.y * 0.8f;
-            }
-        }
-    }
-    
     void Render() override {
         Scene::Render();
         
@@ -99,6 +76,12 @@ public:
         }
     }
     
+    void CreateWall(Vector2 center, Vector2 size) {
+        auto wall = CreateGameObject("Wall");
+        wall->transform->position = center;
+        wall->AddComponent<BoxCollider>(size);
+    }
+    
     void AddRandomBall() {
         auto ball = CreateGameObject("Ball");
         ball->transform->position = {Random(100.0f, 700.0f), 50.0f};
@@ -116,10 +99,10 @@ public:
         auto sprite = ball->AddComponent<SpriteRenderer>(tex);
         
         auto rb = ball->AddComponent<Rigidbody>();
-        rb->velocity = {Random(-100.0f, 100.0f), Random(-50.0f, 50.0f)};
-        rb->drag = 1.0f;
-        rb->useGravity = true;
-        rb->gravity = 300.0f;
+        rb->SetVelocity({Random(-100.0f, 100.0f), Random(-50.0f, 50.0f)});
+        rb->SetDrag(1.0f);
+        rb->SetUseGravity(true);
+        rb->SetGravity(300.0f);
         
         auto collider = ball->AddComponent<CircleCollider>(16.0f);
         
@@ -5,6 +5,15 @@ using namespace RayGame;
 // Forward declaration
 class SpaceShooterScene;
 
+// Collision layers
+enum GameLayer {
+    LayerDefault = 0,
+    LayerPlayer,
+    LayerEnemy,
+    LayerPlayerBullet,
+    LayerEnemyBullet
+};
+
 // Star for background
 struct Star {
     Vector2 position;
@@ -205,6 +214,7 @@ public:
     float fireTimer = 0.0f;
     
     void Update() override;
+    void OnCollisionEnter(Collider* other) override;
     void Shoot();
     
     Scene* scene = nullptr;  // Reference to scene for spawning bullets
@@ -234,7 +244,7 @@ public:
         
         // Destroy if off screen
         if (gameObject->transform->position.y > 700) {
-            gameObject->active = false;
+            gameObject->GetScene()->DestroyGameObject(gameObject->GetHandle());
         }
     }
 };
@@ -245,17 +255,10 @@ public:
     float speed = 500.0f;
     bool isPlayerBullet = true;
     
-    void Update() override {
-        if (!gameObject) return;
-        
-        gameObject->transform->position.y += (isPlayerBullet ? -speed : speed) * GameTime::DeltaTime();
-        
-        // Destroy if off screen
-        if (gameObject->transform->position.y < -10 || 
-            gameObject->transform->position.y > 700) {
-            gameObject->active = false;
-        }
-    }
+    SpaceShooterScene* scene = nullptr;  // Notified when the bullet hits
+    
+    void Update() override;
+    void OnTriggerEnter(Collider* other) override;
 };
 
 
@@ -270,13 +273,31 @@ public:
     SpaceShooterScene() : Scene("Space Shooter") {}
     
     void OnLoad() override {
+        // Explosions are pooled one-shot effects, recycled once their particles die
+        GetParticleSystems().RegisterPreset("Explosion", [](ParticleEmitter& particles) {
+            particles.emissionRate = 0;  // Burst only
+            particles.maxParticles = 50;
+            particles.shape = EmitterShape::Circle;
+            particles.radius = 10;
+            particles.startVelocityMin = {-150, -150};
+            particles.startVelocityMax = {150, 150};
+            particles.acceleration = {0, 100};
+            particles.lifetimeMin = 0.3f;
+            particles.lifetimeMax = 0.8f;
+            particles.startSizeMin = 3;
+            particles.startSizeMax = 8;
+            particles.startColor = {255, 150, 0, 255};
+            particles.emitting = false;
+            particles.loop = false;
+        }, 50);
+        
         // Create starfield background (first, so it renders behind everything)
         auto background = CreateGameObject("Starfield");
         background->AddComponent<StarfieldBackground>();
         
         // Create player
         player = CreateGameObject("Player");
-        player->tag = "Player";
+        player->SetTag("Player");
         player->transform->position = {400, 500};
         
         // Add custom ship renderer instead of sprite
@@ -284,16 +305,23 @@ public:
         
         // Add physics
         auto rb = player->AddComponent<Rigidbody>();
-        rb->drag = 0.9f;
+        rb->SetDrag(0.9f);
         
         auto collider = player->AddComponent<CircleCollider>(16.0f);
+        collider->layer = LayerPlayer;
+        collider->collisionMask = LayerBit(LayerEnemy) | LayerBit(LayerEnemyBullet);
         
         // Add controller
         auto controller = player->AddComponent<PlayerController>();
         controller->scene = this;
         
-        // Add particle emitter for engine trail
-        auto particles = player->AddComponent<ParticleEmitter>();
+        // Engine trail on a child object behind the ship, so it follows
+        // the player's transform
+        auto engine = CreateGameObject("EngineTrail");
+        engine->transform->SetParent(player->transform.get(), false);
+        engine->transform->position = {0, 16};
+        
+        auto particles = engine->AddComponent<ParticleEmitter>();
         particles->emissionRate = 50;
         particles->maxParticles = 100;
         particles->shape = EmitterShape::Circle;
@@ -334,48 +362,24 @@ public:
             }
         }
         
-        // Check bullet-enemy collisions (simplified)
-        auto bullets = FindGameObjectsByTag("Bullet");
-        auto enemies = FindGameObjectsByTag("Enemy");
-        
-        for (auto& bullet : bullets) {
-            auto bulletCollider = bullet->GetComponent<Collider>();
-            if (!bulletCollider) continue;
-            
-            for (auto& enemy : enemies) {
-                auto enemyCollider = enemy->GetComponent<Collider>();
-                if (!enemyCollider) continue;
-                
-                if (bulletCollider->CheckCollision(enemyCollider.get())) {
-                    // Destroy both
-                    bullet->active = false;
-                    enemy->active = false;
-                    score += 10;
-                    
-                    // Spawn explosion particles
-                    SpawnExplosion(enemy->transform->position);
-                    
-                    break;
-                }
-            }
-        }
+    }
+    
+    void OnPlayerHit() {
+        if (!player || !player->active) return;
         
-        // Check player-enemy collisions
-        if (player && player->active) {
-            auto playerCollider = player->GetComponent<Collider>();
-            if (playerCollider) {
-                for (auto& enemy : enemies) {
-                    auto enemyCollider = enemy->GetComponent<Collider>();
-                    if (!enemyCollider) continue;
-                    
-                    if (playerCollider->CheckCollision(enemyCollider.get())) {
-                        // Game over effect
-                        SpawnExplosion(player->transform->position);
-                        player->active = false;
-                    }
-                }
-            }
-        }
+        // Game over effect
+        SpawnExplosion(player->transform->position);
+        DestroyGameObject(player);
+    }
+    
+    void OnBulletHit(GameObject* bullet, GameObject* enemy) {
+        // Destroy both
+        DestroyGameObject(bullet->GetHandle());
+        DestroyGameObject(enemy->GetHandle());
+        score += 10;
+        
+        // Spawn explosion particles
+        SpawnExplosion(enemy->transform->position);
     }
     
     void Render() override {
@@ -396,7 +400,7 @@ public:
             if (Input::GetKeyDown(KEY_R)) {
                 // Reload scene
                 OnUnload();
-                gameObjects.clear();
+                DestroyAllGameObjects();
                 score = 0;
                 enemySpawnRate = 2.0f;
                 OnLoad();
@@ -407,7 +411,7 @@ public:
     
     void SpawnEnemy() {
         auto enemy = CreateGameObject("Enemy");
-        enemy->tag = "Enemy";
+        enemy->SetTag("Enemy");
         
         // Use GetRandomValue directly for testing
         float x = static_cast<float>(GetRandomValue(50, 750));
@@ -418,6 +422,8 @@ public:
         
         // Add collider
         auto collider = enemy->AddComponent<CircleCollider>(18.0f);
+        collider->layer = LayerEnemy;
+        collider->collisionMask = LayerBit(LayerPlayer) | LayerBit(LayerPlayerBullet);
         
         // Add AI
         auto ai = enemy->AddComponent<EnemyAI>();
@@ -428,50 +434,38 @@ public:
     
     void SpawnBullet(Vector2 position, bool isPlayerBullet = true) {
         auto bullet = CreateGameObject("Bullet");
-        bullet->tag = "Bullet";
+        bullet->SetTag("Bullet");
         bullet->transform->position = position;
         
         // Add custom bullet renderer
         auto renderer = bullet->AddComponent<BulletRenderer>();
         renderer->isPlayerBullet = isPlayerBullet;
         
-        // Add collider
+        // Bullets move fast enough to skip over enemies at low frame rates,
+        // so they are swept instead of only tested where they land
+        auto rb = bullet->AddComponent<Rigidbody>();
+        rb->SetDrag(1.0f);
+        rb->SetContinuous(true);
+        
+        // Add collider; bullets never test against other bullets
         auto collider = bullet->AddComponent<CircleCollider>(4.0f);
         collider->isTrigger = true;
+        collider->layer = isPlayerBullet ? LayerPlayerBullet : LayerEnemyBullet;
+        collider->collisionMask = LayerBit(isPlayerBullet ? LayerEnemy : LayerPlayer);
         
         // Add bullet component
         auto bulletComp = bullet->AddComponent<Bullet>();
         bulletComp->isPlayerBullet = isPlayerBullet;
+        bulletComp->scene = this;
+        rb->SetVelocity({0, isPlayerBullet ? -bulletComp->speed : bulletComp->speed});
     }
     
     void SpawnExplosion(Vector2 position) {
-        auto explosion = CreateGameObject("Explosion");
-        explosion->transform->position = position;
-        
-        auto particles = explosion->AddComponent<ParticleEmitter>();
-        particles->emissionRate = 0;  // Burst only
-        particles->maxParticles = 50;
-        particles->shape = EmitterShape::Circle;
-        particles->radius = 10;
-        particles->startVelocityMin = {-150, -150};
-        particles->startVelocityMax = {150, 150};
-        particles->acceleration = {0, 100};
-        particles->lifetimeMin = 0.3f;
-        particles->lifetimeMax = 0.8f;
-        particles->startSizeMin = 3;
-        particles->startSizeMax = 8;
-        particles->startColor = {255, 150, 0, 255};
-        particles->emitting = false;
-        particles->loop = false;
-        
-        particles->Burst(50);
-        
-        // Auto-destroy after 2 seconds
-        // In a real engine, you'd have a component for this
+        GetParticleSystems().Play("Explosion", position);
     }
 };
 
-// PlayerController implementations (after SpaceShooterScene is defined)
+// Bullet and PlayerController implementations (after SpaceShooterScene is defined)
 void PlayerController::Update() {
     if (!gameObject) return;
     
@@ -509,6 +503,33 @@ void PlayerController::Update() {
         gameObject->transform->position.y = 600 - margin;
 }
 
+void Bullet::Update() {
+    if (!gameObject) return;
+    
+    // Destroy if off screen
+    if (gameObject->transform->position.y < -10 || 
+        gameObject->transform->position.y > 700) {
+        gameObject->GetScene()->DestroyGameObject(gameObject->GetHandle());
+    }
+}
+
+void Bullet::OnTriggerEnter(Collider* other) {
+    if (!isPlayerBullet || !scene) return;
+    
+    if (other->layer == LayerEnemy) {
+        scene->OnBulletHit(gameObject, other->GetGameObject());
+    }
+}
+
+void PlayerController::OnCollisionEnter(Collider* other) {
+    if (other->layer != LayerEnemy) return;
+    
+    SpaceShooterScene* gameScene = dynamic_cast<SpaceShooterScene*>(scene);
+    if (gameScene) {
+        gameScene->OnPlayerHit();
+    }
+}
+
 void PlayerController::Shoot() {
     if (!gameObject || !scene) return;
     
@@ -531,6 +552,10 @@ public:
         // Seed random
         srand(static_cast<unsigned int>(GetRandomValue(0, 100000)));
         
+        // Cap live particles, and thin out emission when frames drop below 30 FPS
+        ParticleBudget::SetLimit(4000);
+        ParticleBudget::SetTargetFrameTime(1.0f / 30.0f);
+        
         // Load scene
         auto scene = CreateRef<SpaceShooterScene>();
         
@@ -0,0 +1,254 @@
+#include "RayGame.h"
+#include <cstdio>
+
+using namespace RayGame;
+
+// Headless determinism and stress check for the job system. Runs the same
+// seeded scene (a pile of bodies, some with child objects and particle
+// emitters, plus components that update in parallel stages) with 1, 2, 4
+// and 8 threads and in deterministic mode, hashes the final state of each
+// run and fails if any hash differs. It then reseeds, reloads the scene
+// and runs it again, which must repeat the first run even though the
+// scene's pooled particle effects outlive the reload. Build it with
+// ThreadSanitizer (e.g. xmake f -m debug --cxflags=-fsanitize=thread
+// --ldflags=-fsanitize=thread) to check the parallel paths for races.
+
+static const int BodyCount = 2000;
+static const int FrameCount = 120;
+static const float FrameTime = 1.0f / 60.0f;
+
+// Parallel stage: writes its own Transform
+class Spinner : public Component {
+public:
+    float speed = 0.0f;
+    
+    static void DeclareAccess(ComponentAccess& access) {
+        access.Write<Transform>();
+    }
+    
+    void Update() override {
+        gameObject->transform->rotation += speed * FrameTime;
+    }
+};
+
+// Parallel stage: reads Transform and Rigidbody, writes only itself
+class Odometer : public Component {
+public:
+    float distance = 0.0f;
+    float heading = 0.0f;
+    
+    static void DeclareAccess(ComponentAccess& access) {
+        access.Read<Transform>();
+        access.Read<Rigidbody>();
+    }
+    
+    void Update() override {
+        distance += rigidbody->GetSpeed() * FrameTime;
+        heading += gameObject->transform->Forward().x;
+    }
+    
+    void Start() override {
+        rigidbody = gameObject->GetComponent<Rigidbody>();
+    }
+
+private:
+    Rigidbody* rigidbody = nullptr;
+};
+
+// Parallel stage on child objects: world getters walk the parent's cache
+class Sight : public Component {
+public:
+    Vector2 sum = {0, 0};
+    
+    static void DeclareAccess(ComponentAccess& access) {
+        access.Read<Transform>();
+    }
+    
+    void Update() override {
+        Vector2 tip = gameObject->transform->TransformPoint({0, -10});
+        sum.x += tip.x + gameObject->transform->Forward().y;
+        sum.y += tip.y;
+    }
+};
+
+// Serial (no declared access): turns its object between parallel stages
+class Wobble : public Component {
+public:
+    void Update() override {
+        gameObject->transform->rotation += 3.0f;
+    }
+};
+
+// FNV-1a over the raw bytes of each value
+class StateHash {
+public:
+    template<typename T>
+    void Add(const T& value) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+    
+    uint64_t Get() const { return hash; }
+
+private:
+    uint64_t hash = 14695981039346656037ull;
+};
+
+class StressScene : public Scene {
+public:
+    StressScene() : Scene("Stress Check") {}
+    
+    void OnLoad() override {
+        GetParticleSystems().RegisterPreset("Spark", [](ParticleEmitter& emitter) {
+            emitter.loop = false;
+            emitter.duration = 0.1f;
+            emitter.startVelocityMin = {-200, -200};
+            emitter.startVelocityMax = {200, 200};
+        }, 60);
+        
+        CreateWall({400, -50}, {1000, 100});
+        CreateWall({400, 1050}, {1000, 100});
+        CreateWall({-50, 500}, {100, 1000});
+        CreateWall({850, 500}, {100, 1000});
+        
+        for (int i = 0; i < BodyCount; i++) {
+            auto body = CreateGameObject("Body");
+            body->transform->position = {Random(20.0f, 780.0f), Random(20.0f, 980.0f)};
+            
+            auto rb = body->AddComponent<Rigidbody>();
+            rb->SetVelocity({Random(-150.0f, 150.0f), Random(-150.0f, 150.0f)});
+            rb->SetUseGravity(true);
+            rb->SetGravity(300.0f);
+            body->AddComponent<CircleCollider>(Random(4.0f, 8.0f));
+            
+            body->AddComponent<Spinner>()->speed = Random(-90.0f, 90.0f);
+            body->AddComponent<Odometer>();
+            
+            // Every tenth body carries a child that aims from it, and a trail
+            if (i % 10 == 0) {
+                body->AddComponent<Wobble>();
+                auto trail = body->AddComponent<ParticleEmitter>();
+                trail->emissionRate = 300;
+                trail->maxParticles = 200;
+                trail->lifetimeMin = 0.2f;
+                trail->lifetimeMax = 0.5f;
+                
+                auto marker = CreateGameObject("Marker");
+                marker->transform->SetParent(body->transform.get(), false);
+                marker->transform->position = {12, 0};
+                marker->AddComponent<Sight>();
+            }
+        }
+    }
+    
+    uint64_t Hash() {
+        StateHash hash;
+        for (auto [obj, tf] : View<Transform>()) {
+            hash.Add(tf->position.x);
+            hash.Add(tf->position.y);
+            hash.Add(tf->rotation);
+        }
+        for (auto [obj, odometer] : View<Odometer>()) {
+            hash.Add(odometer->distance);
+            hash.Add(odometer->heading);
+        }
+        for (auto [obj, sight] : View<Sight>()) {
+            hash.Add(sight->sum.x);
+            hash.Add(sight->sum.y);
+        }
+        for (auto [obj, trail] : View<ParticleEmitter>()) {
+            const ParticleBuffer& particles = trail->GetParticles();
+            for (size_t i = 0; i < particles.Count(); i++) {
+                hash.Add(particles.posX[i]);
+                hash.Add(particles.posY[i]);
+            }
+        }
+        hash.Add(ParticleBudget::GetLiveCount());
+        return hash.Get();
+    }
+
+private:
+    void CreateWall(Vector2 position, Vector2 size) {
+        auto wall = CreateGameObject("Wall");
+        wall->transform->position = position;
+        wall->AddComponent<BoxCollider>(size);
+    }
+};
+
+static void RunFrames(StressScene& scene) {
+    for (int frame = 0; frame < FrameCount; frame++) {
+        GameTime::SetDeltaTime(FrameTime);
+        scene.FixedUpdate();
+        PhysicsWorld::Step(FrameTime);
+        if (frame % 5 == 0) {
+            scene.GetParticleSystems().Play("Spark", {400, 500});
+        }
+        scene.Update();
+    }
+}
+
+static uint64_t RunOnce(int threads, bool deterministic) {
+    Rng::SetGlobalSeed(12345);
+    JobSystem::Init(threads);
+    JobSystem::SetDeterministic(deterministic);
+    
+    uint64_t hash;
+    {
+        StressScene scene;
+        scene.OnLoad();
+        scene.Start();
+        RunFrames(scene);
+        hash = scene.Hash();
+    }
+    
+    JobSystem::SetDeterministic(false);
+    JobSystem::Shutdown();
+    return hash;
+}
+
+// Loads and runs the same scene object twice, reseeding in between; both
+// loads happen after Start, so their objects start the same way
+static bool RunReplay(int threads) {
+    JobSystem::Init(threads);
+    
+    uint64_t first, second;
+    {
+        StressScene scene;
+        scene.Start();
+        
+        Rng::SetGlobalSeed(12345);
+        scene.OnLoad();
+        RunFrames(scene);
+        first = scene.Hash();
+        
+        scene.GetParticleSystems().Clear();
+        scene.DestroyAllGameObjects();
+        Rng::SetGlobalSeed(12345);
+        scene.OnLoad();
+        RunFrames(scene);
+        second = scene.Hash();
+    }
+    
+    JobSystem::Shutdown();
+    printf("replay:        %016llx / %016llx\n", (unsigned long long)first, (unsigned long long)second);
+    return first == second;
+}
+
+int main() {
+    uint64_t reference = RunOnce(1, true);
+    printf("deterministic: %016llx\n", (unsigned long long)reference);
+    
+    bool matched = true;
+    for (int threads : {1, 2, 4, 8}) {
+        uint64_t hash = RunOnce(threads, false);
+        printf("%d thread(s):  %016llx\n", threads, (unsigned long long)hash);
+        matched = matched && hash == reference;
+    }
+    
+    matched = RunReplay(4) && matched;
+    
+    printf(matched ? "OK\n" : "MISMATCH\n");
+    return matched ? 0 : 1;
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "Core.h"
+
+namespace RayGame {
+
+// Incrementally updated bounding volume hierarchy.
+// Leaves hold fattened bounds so small movements don't touch the tree, and
+// the tree is kept balanced with rotations as proxies are inserted and removed.
+class RAYGAME_API DynamicAABBTree {
+public:
+    static constexpr int Null = -1;
+    
+    DynamicAABBTree(float margin = 16.0f) : margin(margin) {}
+    
+    void SetMargin(float value) { margin = value; }
+    float GetMargin() const { return margin; }
+    
+    int CreateProxy(const Rectangle& bounds, void* userData) {
+        int proxy = AllocateNode();
+        nodes[proxy].box = Fatten(ToBox(bounds));
+        nodes[proxy].userData = userData;
+        nodes[proxy].height = 0;
+        InsertLeaf(proxy);
+        proxyCount++;
+        return proxy;
+    }
+    
+    void DestroyProxy(int proxy) {
+        if (proxy < 0 || proxy >= (int)nodes.size() || !nodes[proxy].IsLeaf()) return;
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        proxyCount--;
+    }
+    
+    // Returns true if the proxy had to be reinserted
+    bool MoveProxy(int proxy, const Rectangle& bounds) {
+        Box box = ToBox(bounds);
+        if (nodes[proxy].box.Contains(box)) return false;
+        
+        RemoveLeaf(proxy);
+        nodes[proxy].box = Fatten(box);
+        InsertLeaf(proxy);
+        return true;
+    }
+    
+    void* GetUserData(int proxy) const { return nodes[proxy].userData; }
+    
+    Rectangle GetFatBounds(int proxy) const {
+        const Box& b = nodes[proxy].box;
+        return {b.minX, b.minY, b.maxX - b.minX, b.maxY - b.minY};
+    }
+    
+    // Calls callback(proxy) for every leaf whose fat bounds overlap rect.
+    // Return false from the callback to stop the query early.
+    template<typename F>
+    void Query(const Rectangle& rect, F&& callback) const {
+        if (root == Null) return;
+        
+        Box box = ToBox(rect);
+        stack.clear();
+        stack.push_back(root);
+        
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            
+            const Node& node = nodes[id];
+            if (!node.box.Overlaps(box)) continue;
+            
+            if (node.IsLeaf()) {
+                if (!callback(id)) return;
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+    
+    // Walks leaves whose fat bounds the segment from -> to crosses.
+    // callback(proxy, maxFraction) returns the new max fraction along the
+    // segment: 0 stops the cast, a smaller value clips it.
+    template<typename F>
+    void RayCast(Vector2 from, Vector2 to, F&& callback) const {
+        if (root == Null) return;
+        
+        Vector2 d = {to.x - from.x, to.y - from.y};
+        float maxFraction = 1.0f;
+        
+        stack.clear();
+        stack.push_back(root);
+        
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            
+            const Node& node = nodes[id];
+            if (!SegmentOverlaps(node.box, from, d, maxFraction)) continue;
+            
+            if (node.IsLeaf()) {
+                float value = callback(id, maxFraction);
+                if (value <= 0.0f) return;
+                if (value < maxFraction) maxFraction = value;
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+    
+    void Clear() {
+        nodes.clear();
+        root = Null;
+        freeList = Null;
+        proxyCount = 0;
+    }
+    
+    int GetHeight() const { return root == Null ? 0 : nodes[root].height; }
+    int GetProxyCount() const { return proxyCount; }
+
+private:
+    struct Box {
+        float minX, minY, maxX, maxY;
+        
+        bool Contains(const Box& o) const {
+            return minX <= o.minX && minY <= o.minY && o.maxX <= maxX && o.maxY <= maxY;
+        }
+        
+        bool Overlaps(const Box& o) const {
+            return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+        }
+        
+        float Perimeter() const {
+            return 2.0f * ((maxX - minX) + (maxY - minY));
+        }
+        
+        static Box Union(const Box& a, const Box& b) {
+            return {
+                std::min(a.minX, b.minX), std::min(a.minY, b.minY),
+                std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)
+            };
+        }
+    };
+    
+    struct Node {
+        Box box;
+        void* userData = nullptr;
+        int parent = Null;  // Next free node while on the free list
+        int child1 = Null;
+        int child2 = Null;
+        int height = -1;    // 0 for leaves, -1 for free nodes
+        
+        bool IsLeaf() const { return child1 == Null && height == 0; }
+    };
+    
+    std::vector<Node> nodes;
+    mutable std::vector<int> stack;
+    int root = Null;
+    int freeList = Null;
+    int proxyCount = 0;
+    float margin;
+    
+    static Box ToBox(const Rectangle& r) {
+        return {r.x, r.y, r.x + r.width, r.y + r.height};
+    }
+    
+    Box Fatten(const Box& b) const {
+        return {b.minX - margin, b.minY - margin, b.maxX + margin, b.maxY + margin};
+    }
+    
+    static bool SegmentOverlaps(const Box& b, Vector2 from, Vector2 d, float maxFraction) {
+        float tMin = 0.0f;
+        float tMax = maxFraction;
+        
+        const float origin[2] = {from.x, from.y};
+        const float dir[2] = {d.x, d.y};
+        const float lo[2] = {b.minX, b.minY};
+        const float hi[2] = {b.maxX, b.maxY};
+        
+        for (int axis = 0; axis < 2; axis++) {
+            if (std::fabs(dir[axis]) < 1e-8f) {
+                if (origin[axis] < lo[axis] || origin[axis] > hi[axis]) return false;
+                continue;
+            }
+            
+            float inv = 1.0f / dir[axis];
+            float t1 = (lo[axis] - origin[axis]) * inv;
+            float t2 = (hi[axis] - origin[axis]) * inv;
+            if (t1 > t2) std::swap(t1, t2);
+            
+            tMin = std::max(tMin, t1);
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) return false;
+        }
+        return true;
+    }
+    
+    int AllocateNode() {
+        if (freeList == Null) {
+            nodes.emplace_back();
+            return (int)nodes.size() - 1;
+        }
+        
+        int id = freeList;
+        freeList = nodes[id].parent;
+        nodes[id] = Node();
+        return id;
+    }
+    
+    void FreeNode(int id) {
+        nodes[id].parent = freeList;
+        nodes[id].height = -1;
+        nodes[id].child1 = Null;
+        nodes[id].child2 = Null;
+        nodes[id].userData = nullptr;
+        freeList = id;
+    }
+    
+    void InsertLeaf(int leaf) {
+        if (root == Null) {
+            root = leaf;
+            nodes[root].parent = Null;
+            return;
+        }
+        
+        // Descend towards the sibling that grows the tree's perimeter the least
+        Box leafBox = nodes[leaf].box;
+        int index = root;
+        while (!nodes[index].IsLeaf()) {
+            const Node& node = nodes[index];
+            int child1 = node.child1;
+            int child2 = node.child2;
+            
+            float area = node.box.Perimeter();
+            float combinedArea = Box::Union(node.box, leafBox).Perimeter();
+            
+            // Cost of making a new parent for this node and the new leaf
+            float cost = 2.0f * combinedArea;
+            // Minimum cost of pushing the leaf further down the tree
+            float inheritanceCost = 2.0f * (combinedArea - area);
+            
+            float cost1 = DescendCost(child1, leafBox) + inheritanceCost;
+            float cost2 = DescendCost(child2, leafBox) + inheritanceCost;
+            
+            if (cost < cost1 && cost < cost2) break;
+            index = cost1 < cost2 ? child1 : child2;
+        }
+        
+        int sibling = index;
+        int oldParent = nodes[sibling].parent;
+        int newParent = AllocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = Box::Union(leafBox, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+        
+        if (oldParent != Null) {
+            if (nodes[oldParent].child1 == sibling) {
+                nodes[oldParent].child1 = newParent;
+            } else {
+                nodes[oldParent].child2 = newParent;
+            }
+        } else {
+            root = newParent;
+        }
+        
+        RefitAncestors(nodes[leaf].parent);
+    }
+    
+    float DescendCost(int child, const Box& leafBox) const {
+        Box combined = Box::Union(leafBox, nodes[child].box);
+        if (nodes[child].IsLeaf()) {
+            return combined.Perimeter();
+        }
+        return combined.Perimeter() - nodes[child].box.Perimeter();
+    }
+    
+    void RemoveLeaf(int leaf) {
+        if (leaf == root) {
+            root = Null;
+            return;
+        }
+        
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+        
+        if (grandParent != Null) {
+            if (nodes[grandParent].child1 == parent) {
+                nodes[grandParent].child1 = sibling;
+            } else {
+                nodes[grandParent].child2 = sibling;
+            }
+            nodes[sibling].parent = grandParent;
+            FreeNode(parent);
+            RefitAncestors(grandParent);
+        } else {
+            root = sibling;
+            nodes[sibling].parent = Null;
+            FreeNode(parent);
+        }
+        
+        nodes[leaf].parent = Null;
+    }
+    
+    void RefitAncestors(int index) {
+        while (index != Null) {
+            index = Balance(index);
+            
+            Node& node = nodes[index];
+            const Node& c1 = nodes[node.child1];
+            const Node& c2 = nodes[node.child2];
+            node.height = 1 + std::max(c1.height, c2.height);
+            node.box = Box::Union(c1.box, c2.box);
+            
+            index = node.parent;
+        }
+    }
+    
+    // Rotates the subtree at a if it is imbalanced; returns the new subtree root
+    int Balance(int a) {
+        Node& A = nodes[a];
+        if (A.IsLeaf() || A.height < 2) return a;
+        
+        int b = A.child1;
+        int c = A.child2;
+        int balance = nodes[c].height - nodes[b].height;
+        
+        if (balance > 1) return Rotate(a, c, b);
+        if (balance < -1) return Rotate(a, b, c);
+        return a;
+    }
+    
+    // Promotes the taller child 'up' above 'a'; 'other' is a's remaining child
+    int Rotate(int a, int up, int other) {
+        Node& A = nodes[a];
+        Node& U = nodes[up];
+        int f = U.child1;
+        int g = U.child2;
+        
+        // Swap a and up
+        U.child1 = a;
+        U.parent = A.parent;
+        A.parent = up;
+        
+        if (U.parent != Null) {
+            if (nodes[U.parent].child1 == a) {
+                nodes[U.parent].child1 = up;
+            } else {
+                nodes[U.parent].child2 = up;
+            }
+        } else {
+            root = up;
+        }
+        
+        // Keep the taller grandchild under 'up', hand the other to 'a'
+        int keep = f, give = g;
+        if (nodes[f].height < nodes[g].height) {
+            keep = g;
+            give = f;
+        }
+        
+        U.child2 = keep;
+        if (A.child1 == up) {
+            A.child1 = give;
+        } else {
+            A.child2 = give;
+        }
+        nodes[give].parent = a;
+        
+        A.box = Box::Union(nodes[other].box, nodes[give].box);
+        A.height = 1 + std::max(nodes[other].height, nodes[give].height);
+        U.box = Box::Union(A.box, nodes[keep].box);
+        U.height = 1 + std::max(A.height, nodes[keep].height);
+        
+        return up;
+    }
+};
+
+}
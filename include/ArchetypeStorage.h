@@ -0,0 +1,605 @@
+#pragma once
+
+#include "Core.h"
+#include "ComponentType.h"
+#include "Component.h"
+#include "GameObject.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace RayGame {
+
+template<typename... Ts>
+class ComponentView;
+
+// Groups a scene's objects by the exact set of component types they hold.
+// Each archetype keeps one contiguous column of component pointers per
+// type, so a walk visits every component of a type back to back instead of
+// hopping from object to object. Objects move between archetypes when
+// components are added or removed; GameObject still owns its components.
+class RAYGAME_API ArchetypeStorage {
+public:
+    static constexpr uint32_t Invalid = 0xFFFFFFFFu;
+    
+    struct Archetype {
+        std::vector<ComponentTypeId> types;            // Sorted; repeated for several components of a type
+        std::vector<GameObject*> entities;             // One per row
+        std::vector<std::vector<Component*>> columns;  // One per entry in types
+    };
+    
+    ArchetypeStorage() = default;
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+    ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+    
+    ~ArchetypeStorage() {
+        Clear();
+    }
+    
+    void Add(GameObject* obj) {
+        if (obj->storage == this) return;
+        if (obj->storage) obj->storage->Remove(obj);
+        
+        obj->storage = this;
+        Place(obj);
+    }
+    
+    void Remove(GameObject* obj) {
+        if (obj->storage != this) return;
+        
+        Unplace(obj);
+        obj->storage = nullptr;
+    }
+    
+    // Moves an object to the archetype matching its current components
+    void Refresh(GameObject* obj) {
+        if (obj->storage != this) return;
+        
+        Unplace(obj);
+        Place(obj);
+    }
+    
+    // Forgets every object; archetypes are kept for reuse
+    void Clear() {
+        for (auto& arch : archetypes) {
+            for (auto* obj : arch.entities) {
+                if (!obj) continue;
+                obj->storage = nullptr;
+                obj->archetypeIndex = Invalid;
+            }
+            arch.entities.clear();
+            for (auto& column : arch.columns) {
+                column.clear();
+            }
+        }
+        
+        for (auto* obj : queued) {
+            obj->storage = nullptr;
+            obj->queued = false;
+        }
+        queued.clear();
+        hasHoles = false;
+    }
+    
+    enum class Callback { Update, FixedUpdate, Render };
+    
+    // Runs one callback type by type: for each component type that overrides
+    // it, every column of that type in every archetype, as tight loops
+    // through the same direct call. Types run in registration order.
+    // Consecutive types that declare non-conflicting access form a stage
+    // whose rows are spread over the job system (Render always stays on the
+    // calling thread). startedOnly skips objects that haven't had Start yet.
+    // Before a parallel stage, world transforms are brought up to date if
+    // anything since the last refresh may have moved them, and the world
+    // cache stays frozen while the stage runs.
+    void Dispatch(Callback callback, bool startedOnly) {
+        BeginBatch();
+        
+        bool transformsStale = true;
+        for (const Stage& stage : GetPlan(callback)) {
+            if (!stage.parallel) {
+                for (ComponentTypeId type : stage.types) {
+                    ComponentCallback fn = GetCallback(typeColumns[type].info, callback);
+                    for (const auto& location : typeColumns[type].columns) {
+                        RunRows(fn, location, 0, archetypes[location.archetype].entities.size(), startedOnly);
+                    }
+                }
+                transformsStale = true;  // Undeclared updates may write any Transform
+                continue;
+            }
+            
+            if (transformsStale) UpdateTransforms();
+            transformsStale = stage.writesTransform;
+            
+            chunks.clear();
+            for (ComponentTypeId type : stage.types) {
+                ComponentCallback fn = GetCallback(typeColumns[type].info, callback);
+                for (const auto& location : typeColumns[type].columns) {
+                    size_t rows = archetypes[location.archetype].entities.size();
+                    for (size_t begin = 0; begin < rows; begin += RowsPerChunk) {
+                        chunks.push_back({fn, location, begin, std::min(rows, begin + RowsPerChunk)});
+                    }
+                }
+            }
+            
+            Transform::SetCacheFrozen(true);
+            JobSystem::ParallelFor(chunks.size(), 1, [this, startedOnly](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++) {
+                    const RowChunk& chunk = chunks[i];
+                    RunRows(chunk.fn, chunk.location, chunk.begin, chunk.end, startedOnly);
+                }
+            });
+            Transform::SetCacheFrozen(false);
+        }
+        
+        EndBatch();
+    }
+    
+    // Refreshes cached world transforms, root by root with parents before
+    // children. Inactive roots too, since their children may be active.
+    void UpdateTransforms() {
+        ComponentTypeId id = ComponentTypes::Id<Transform>();
+        if (id >= typeColumns.size()) return;
+        
+        BeginBatch();
+        for (const auto& location : typeColumns[id].columns) {
+            Archetype& arch = archetypes[location.archetype];
+            const auto& column = arch.columns[location.column];
+            for (size_t row = 0; row < arch.entities.size(); row++) {
+                if (!arch.entities[row]) continue;
+                
+                auto* transform = static_cast<Transform*>(column[row]);
+                if (transform && !transform->GetParent()) transform->UpdateHierarchy();
+            }
+        }
+        EndBatch();
+    }
+    
+    // Between BeginBatch and EndBatch objects keep their rows: removals
+    // leave holes and placements queue up. EndBatch compacts the holes and
+    // places each queued object once, however many changes it went
+    // through. Walks and views open a batch for their duration.
+    void BeginBatch() { iterating++; }
+    
+    void EndBatch() {
+        if (--iterating == 0) Flush();
+    }
+    
+    size_t GetArchetypeCount() const { return archetypes.size(); }
+    const Archetype& GetArchetype(size_t index) const { return archetypes[index]; }
+    
+    // Active objects holding every one of Ts, matched by exact type
+    template<typename... Ts>
+    ComponentView<Ts...> View() {
+        return ComponentView<Ts...>(this);
+    }
+    
+    // Calls fn(component) for every enabled component of every active object,
+    // archetype by archetype and column by column. Adding, removing or
+    // re-archetyping objects from inside fn is deferred until the walk ends.
+    template<typename F>
+    void ForEachComponent(F&& fn) {
+        BeginBatch();
+        
+        for (size_t a = 0; a < archetypes.size(); a++) {
+            Archetype& arch = archetypes[a];
+            for (size_t c = 0; c < arch.columns.size(); c++) {
+                for (size_t row = 0; row < arch.entities.size(); row++) {
+                    GameObject* obj = arch.entities[row];
+                    if (!obj || !obj->active) continue;
+                    
+                    Component* component = arch.columns[c][row];
+                    if (component && component->IsEnabled()) {
+                        fn(component);
+                    }
+                }
+            }
+        }
+        
+        EndBatch();
+    }
+
+private:
+    template<typename...> friend class ComponentView;
+    
+    // Archetypes matching one view signature. Archetypes are never removed,
+    // so a query only has to look at the ones created since its last use.
+    struct Query {
+        std::vector<ComponentTypeId> types;  // In view order
+        std::vector<uint32_t> matches;       // Matching archetype indices
+        std::vector<uint32_t> columns;       // types.size() column indices per match
+        size_t scanned = 0;                  // Archetypes checked so far
+    };
+    
+    // Where the columns of one component type live
+    struct ColumnLocation {
+        uint32_t archetype;
+        uint32_t column;
+    };
+    
+    struct TypeColumns {
+        ComponentTypeInfo info;
+        std::vector<ColumnLocation> columns;
+    };
+    
+    // Types that run together; serial stages run on the calling thread
+    struct Stage {
+        bool parallel;
+        std::vector<ComponentTypeId> types;
+        bool writesTransform = false;  // Some type in the stage declares Write<Transform>
+    };
+    
+    struct Plan {
+        std::vector<Stage> stages;
+        uint32_t version = 0;
+    };
+    
+    struct RowChunk {
+        ComponentCallback fn;
+        ColumnLocation location;
+        size_t begin;
+        size_t end;
+    };
+    
+    static constexpr size_t RowsPerChunk = 256;
+    
+    std::vector<Archetype> archetypes;
+    std::vector<TypeColumns> typeColumns;  // By component type id
+    uint32_t typesVersion = 1;             // Bumped when a type gets its first column
+    Plan plans[3];                         // By Callback
+    std::vector<RowChunk> chunks;          // Scratch for parallel stages
+    std::map<std::vector<ComponentTypeId>, uint32_t> lookup;
+    std::vector<ComponentTypeId> signature;  // Scratch
+    std::vector<GameObject*> queued;         // Waiting for the current walk to end
+    std::vector<Query> queries;              // By view signature id
+    int iterating = 0;
+    bool hasHoles = false;                   // Rows emptied during a walk
+    
+    static inline std::atomic<uint32_t> nextQueryId{0};
+    
+    template<typename... Ts>
+    static uint32_t QueryId() {
+        static const uint32_t id = nextQueryId++;
+        return id;
+    }
+    
+    template<typename... Ts>
+    uint32_t UpdateQuery() {
+        uint32_t id = QueryId<Ts...>();
+        if (id >= queries.size()) queries.resize(id + 1);
+        
+        Query& query = queries[id];
+        if (query.types.empty()) {
+            query.types = {ComponentTypes::Id<Ts>()...};
+        }
+        
+        for (; query.scanned < archetypes.size(); query.scanned++) {
+            const Archetype& arch = archetypes[query.scanned];
+            size_t first = query.columns.size();
+            bool matched = true;
+            
+            for (ComponentTypeId type : query.types) {
+                auto it = std::lower_bound(arch.types.begin(), arch.types.end(), type);
+                if (it == arch.types.end() || *it != type) {
+                    matched = false;
+                    break;
+                }
+                query.columns.push_back((uint32_t)(it - arch.types.begin()));
+            }
+            
+            if (matched) {
+                query.matches.push_back((uint32_t)query.scanned);
+            } else {
+                query.columns.resize(first);
+            }
+        }
+        return id;
+    }
+    
+    static ComponentCallback GetCallback(const ComponentTypeInfo& info, Callback callback) {
+        switch (callback) {
+            case Callback::Update: return info.update;
+            case Callback::FixedUpdate: return info.fixedUpdate;
+            default: return info.render;
+        }
+    }
+    
+    void RunRows(ComponentCallback fn, ColumnLocation location, size_t begin, size_t end, bool startedOnly) {
+        Archetype& arch = archetypes[location.archetype];
+        const auto& column = arch.columns[location.column];
+        
+        for (size_t row = begin; row < end; row++) {
+            GameObject* obj = arch.entities[row];
+            if (!obj || !obj->active || (startedOnly && !obj->started)) continue;
+            
+            Component* component = column[row];
+            if (component && component->IsEnabled()) {
+                fn(component);
+            }
+        }
+    }
+    
+    static bool Overlaps(const std::vector<ComponentTypeId>& a, const std::vector<ComponentTypeId>& b) {
+        for (ComponentTypeId type : a) {
+            if (std::find(b.begin(), b.end(), type) != b.end()) return true;
+        }
+        return false;
+    }
+    
+    // Writes of one side against reads or writes of the other
+    static bool Conflicts(const ComponentAccess& a, const ComponentAccess& b) {
+        return Overlaps(a.writes, b.writes) || Overlaps(a.writes, b.reads) || Overlaps(b.writes, a.reads);
+    }
+    
+    // Groups the types overriding a callback into stages, greedily and in
+    // registration order; rebuilt only when new component types show up
+    const std::vector<Stage>& GetPlan(Callback callback) {
+        Plan& plan = plans[(int)callback];
+        if (plan.version == typesVersion) return plan.stages;
+        
+        plan.stages.clear();
+        plan.version = typesVersion;
+        ComponentTypeId transformId = ComponentTypes::Id<Transform>();
+        
+        for (size_t type = 0; type < typeColumns.size(); type++) {
+            const ComponentTypeInfo& info = typeColumns[type].info;
+            if (typeColumns[type].columns.empty() || !GetCallback(info, callback)) continue;
+            
+            bool parallel = info.declaresAccess && callback != Callback::Render;
+            bool fits = parallel && !plan.stages.empty() && plan.stages.back().parallel;
+            if (fits) {
+                for (ComponentTypeId other : plan.stages.back().types) {
+                    if (Conflicts(info.access, typeColumns[other].info.access)) {
+                        fits = false;
+                        break;
+                    }
+                }
+            }
+            
+            if (fits || (!parallel && !plan.stages.empty() && !plan.stages.back().parallel)) {
+                plan.stages.back().types.push_back((ComponentTypeId)type);
+            } else {
+                plan.stages.push_back({parallel, {(ComponentTypeId)type}});
+            }
+            
+            const auto& writes = info.access.writes;
+            if (std::find(writes.begin(), writes.end(), transformId) != writes.end()) {
+                plan.stages.back().writesTransform = true;
+            }
+        }
+        return plan.stages;
+    }
+    
+    void Place(GameObject* obj) {
+        if (iterating) {
+            if (!obj->queued) {
+                obj->queued = true;
+                queued.push_back(obj);
+            }
+            return;
+        }
+        
+        const auto& components = obj->GetAllComponents();
+        signature.clear();
+        for (const auto& component : components) {
+            signature.push_back(component->GetTypeId());
+        }
+        std::sort(signature.begin(), signature.end());
+        
+        uint32_t index = FindOrCreate(signature);
+        Archetype& arch = archetypes[index];
+        uint32_t row = (uint32_t)arch.entities.size();
+        
+        arch.entities.push_back(obj);
+        for (auto& column : arch.columns) {
+            column.push_back(nullptr);
+        }
+        
+        // The n-th component of a type goes to the n-th column of that type
+        for (const auto& component : components) {
+            size_t c = std::lower_bound(arch.types.begin(), arch.types.end(), component->GetTypeId()) - arch.types.begin();
+            while (arch.columns[c][row]) c++;
+            arch.columns[c][row] = component.get();
+        }
+        
+        obj->archetypeIndex = index;
+        obj->archetypeRow = row;
+    }
+    
+    void Unplace(GameObject* obj) {
+        if (obj->queued) {
+            queued.erase(std::find(queued.begin(), queued.end(), obj));
+            obj->queued = false;
+        }
+        if (obj->archetypeIndex == Invalid) return;
+        
+        Archetype& arch = archetypes[obj->archetypeIndex];
+        uint32_t row = obj->archetypeRow;
+        obj->archetypeIndex = Invalid;
+        
+        if (iterating) {
+            // Rows can't move under a walk; leave a hole and compact later
+            arch.entities[row] = nullptr;
+            for (auto& column : arch.columns) {
+                column[row] = nullptr;
+            }
+            hasHoles = true;
+            return;
+        }
+        RemoveRow(arch, row);
+    }
+    
+    // Swap-with-last keeps rows dense
+    void RemoveRow(Archetype& arch, uint32_t row) {
+        uint32_t last = (uint32_t)arch.entities.size() - 1;
+        if (row != last) {
+            arch.entities[row] = arch.entities[last];
+            for (auto& column : arch.columns) {
+                column[row] = column[last];
+            }
+            if (arch.entities[row]) {
+                arch.entities[row]->archetypeRow = row;
+            }
+        }
+        
+        arch.entities.pop_back();
+        for (auto& column : arch.columns) {
+            column.pop_back();
+        }
+    }
+    
+    uint32_t FindOrCreate(const std::vector<ComponentTypeId>& types) {
+        auto it = lookup.find(types);
+        if (it != lookup.end()) return it->second;
+        
+        uint32_t index = (uint32_t)archetypes.size();
+        archetypes.emplace_back();
+        archetypes.back().types = types;
+        archetypes.back().columns.resize(types.size());
+        lookup.emplace(types, index);
+        
+        for (size_t c = 0; c < types.size(); c++) {
+            ComponentTypeId type = types[c];
+            if (type >= typeColumns.size()) typeColumns.resize(type + 1);
+            if (typeColumns[type].columns.empty()) {
+                typeColumns[type].info = ComponentTypes::GetInfo(type);
+                typesVersion++;
+            }
+            typeColumns[type].columns.push_back({index, (uint32_t)c});
+        }
+        return index;
+    }
+    
+    void Flush() {
+        if (hasHoles) {
+            for (auto& arch : archetypes) {
+                for (size_t row = arch.entities.size(); row-- > 0;) {
+                    if (!arch.entities[row]) {
+                        RemoveRow(arch, (uint32_t)row);
+                    }
+                }
+            }
+            hasHoles = false;
+        }
+        
+        std::vector<GameObject*> pending;
+        pending.swap(queued);
+        for (auto* obj : pending) {
+            obj->queued = false;
+            Place(obj);
+        }
+    }
+};
+
+// Walks the objects that hold every component type in Ts, archetype by
+// archetype, without allocating. Use it in a range-for:
+//
+//     for (auto [obj, rb, collider] : scene.View<Rigidbody, CircleCollider>()) { ... }
+//
+// or call ForEach. Structural changes made during the walk are deferred
+// until the view is destroyed.
+template<typename... Ts>
+class ComponentView {
+public:
+    static_assert(sizeof...(Ts) > 0, "A view needs at least one component type");
+    
+    using Row = std::tuple<GameObject*, Ts*...>;
+    
+    class Iterator {
+    public:
+        Iterator(ArchetypeStorage* storage, uint32_t query, size_t match)
+            : storage(storage), query(query), match(match), row(0) {
+            SkipEmpty();
+        }
+        
+        Row operator*() const {
+            return Get(std::index_sequence_for<Ts...>{});
+        }
+        
+        Iterator& operator++() {
+            row++;
+            SkipEmpty();
+            return *this;
+        }
+        
+        bool operator==(const Iterator& other) const {
+            return match == other.match && row == other.row;
+        }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+    
+    private:
+        ArchetypeStorage* storage;
+        uint32_t query;
+        size_t match;
+        size_t row;
+        
+        const ArchetypeStorage::Archetype& Current() const {
+            return storage->archetypes[storage->queries[query].matches[match]];
+        }
+        
+        // Steps over holes, inactive objects and exhausted archetypes
+        void SkipEmpty() {
+            const auto& matches = storage->queries[query].matches;
+            while (match < matches.size()) {
+                const auto& entities = Current().entities;
+                for (; row < entities.size(); row++) {
+                    if (entities[row] && entities[row]->active) return;
+                }
+                match++;
+                row = 0;
+            }
+        }
+        
+        template<size_t... I>
+        Row Get(std::index_sequence<I...>) const {
+            const auto& arch = Current();
+            const uint32_t* columns = &storage->queries[query].columns[match * sizeof...(Ts)];
+            return Row(arch.entities[row], static_cast<Ts*>(arch.columns[columns[I]][row])...);
+        }
+    };
+    
+    explicit ComponentView(ArchetypeStorage* storage) : storage(storage) {
+        query = storage->UpdateQuery<Ts...>();
+        storage->BeginBatch();
+    }
+    
+    ~ComponentView() {
+        storage->EndBatch();
+    }
+    
+    ComponentView(const ComponentView&) = delete;
+    ComponentView& operator=(const ComponentView&) = delete;
+    
+    Iterator begin() const { return Iterator(storage, query, 0); }
+    Iterator end() const { return Iterator(storage, query, storage->queries[query].matches.size()); }
+    
+    // Calls fn(GameObject&, Ts&...) for every match
+    template<typename F>
+    void ForEach(F&& fn) const {
+        ForEach(fn, std::index_sequence_for<Ts...>{});
+    }
+
+private:
+    ArchetypeStorage* storage;
+    uint32_t query;
+    
+    template<typename F, size_t... I>
+    void ForEach(F& fn, std::index_sequence<I...>) const {
+        // Re-read the query each time; a nested view may grow the query list
+        for (size_t m = 0; m < storage->queries[query].matches.size(); m++) {
+            const auto& q = storage->queries[query];
+            auto& arch = storage->archetypes[q.matches[m]];
+            const uint32_t* columns = &q.columns[m * sizeof...(Ts)];
+            
+            for (size_t row = 0; row < arch.entities.size(); row++) {
+                GameObject* obj = arch.entities[row];
+                if (!obj || !obj->active) continue;
+                fn(*obj, *static_cast<Ts*>(arch.columns[columns[I]][row])...);
+            }
+        }
+    }
+};
+
+}
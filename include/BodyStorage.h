@@ -0,0 +1,272 @@
+#pragma once
+
+#include "Core.h"
+#include "Component.h"
+#include "GameObject.h"
+#include "JobSystem.h"
+#include <cstdint>
+
+namespace RayGame {
+
+// Packed structure-of-arrays state for every live Rigidbody.
+// Rigidbody components only hold an index into these lanes; PhysicsWorld::Step
+// integrates all of them in one pass instead of one virtual Update per body.
+class RAYGAME_API BodyStorage {
+public:
+    static constexpr uint32_t Invalid = 0xFFFFFFFFu;
+    
+    // Bodies per batch when integration is spread across the job system
+    static constexpr size_t IntegrateBatch = 1024;
+    
+    // Hot lanes, touched by Integrate every step
+    static inline std::vector<float> velX, velY;
+    static inline std::vector<float> prevVelX, prevVelY;  // Velocity before this step's forces
+    static inline std::vector<float> accX, accY;
+    static inline std::vector<float> invMass;
+    static inline std::vector<float> drag;
+    static inline std::vector<float> gravityAccel;  // gravity if enabled, else 0
+    static inline std::vector<float> posX, posY;    // Scratch, filled from Transform
+    static inline std::vector<float> prevPosX, prevPosY;  // Position before the last step
+    static inline std::vector<float> simulate;      // 1 if the body moves this step
+    static inline std::vector<float> timeOfImpact;  // Fraction of the step moved, < 1 after a swept hit
+    
+    // Cold lanes, only read by accessors and the gather pass
+    static inline std::vector<float> mass;
+    static inline std::vector<float> gravity;
+    static inline std::vector<uint8_t> useGravity;
+    static inline std::vector<uint8_t> kinematic;
+    static inline std::vector<uint8_t> continuous;
+    static inline std::vector<uint8_t> sleeping;
+    static inline std::vector<float> sleepTime;     // Seconds spent below the sleep speed
+    static inline std::vector<Component*> owners;
+    static inline std::vector<Transform*> transforms;
+    static inline std::vector<uint32_t*> handles;  // Owner's index field, patched on swap
+    
+    static uint32_t Create(Component* owner, uint32_t* handle) {
+        uint32_t index = (uint32_t)owners.size();
+        
+        velX.push_back(0); velY.push_back(0);
+        prevVelX.push_back(0); prevVelY.push_back(0);
+        accX.push_back(0); accY.push_back(0);
+        invMass.push_back(1.0f);
+        drag.push_back(0.99f);
+        gravityAccel.push_back(0);
+        posX.push_back(0); posY.push_back(0);
+        prevPosX.push_back(0); prevPosY.push_back(0);
+        simulate.push_back(0);
+        timeOfImpact.push_back(1.0f);
+        
+        mass.push_back(1.0f);
+        gravity.push_back(0);
+        useGravity.push_back(0);
+        kinematic.push_back(0);
+        continuous.push_back(0);
+        sleeping.push_back(0);
+        sleepTime.push_back(0);
+        owners.push_back(owner);
+        transforms.push_back(nullptr);
+        handles.push_back(handle);
+        
+        return index;
+    }
+    
+    // Swap-with-last removal; the moved body's handle is patched in place
+    static void Destroy(uint32_t index) {
+        if (index >= owners.size()) return;
+        
+        uint32_t last = (uint32_t)owners.size() - 1;
+        if (index != last) {
+            MoveLane(velX, index, last); MoveLane(velY, index, last);
+            MoveLane(prevVelX, index, last); MoveLane(prevVelY, index, last);
+            MoveLane(accX, index, last); MoveLane(accY, index, last);
+            MoveLane(invMass, index, last);
+            MoveLane(drag, index, last);
+            MoveLane(gravityAccel, index, last);
+            MoveLane(posX, index, last); MoveLane(posY, index, last);
+            MoveLane(prevPosX, index, last); MoveLane(prevPosY, index, last);
+            MoveLane(simulate, index, last);
+            MoveLane(timeOfImpact, index, last);
+            
+            MoveLane(mass, index, last);
+            MoveLane(gravity, index, last);
+            MoveLane(useGravity, index, last);
+            MoveLane(kinematic, index, last);
+            MoveLane(continuous, index, last);
+            MoveLane(sleeping, index, last);
+            MoveLane(sleepTime, index, last);
+            MoveLane(owners, index, last);
+            MoveLane(transforms, index, last);
+            MoveLane(handles, index, last);
+            
+            *handles[index] = index;
+        }
+        
+        velX.pop_back(); velY.pop_back();
+        prevVelX.pop_back(); prevVelY.pop_back();
+        accX.pop_back(); accY.pop_back();
+        invMass.pop_back();
+        drag.pop_back();
+        gravityAccel.pop_back();
+        posX.pop_back(); posY.pop_back();
+        prevPosX.pop_back(); prevPosY.pop_back();
+        simulate.pop_back();
+        timeOfImpact.pop_back();
+        
+        mass.pop_back();
+        gravity.pop_back();
+        useGravity.pop_back();
+        kinematic.pop_back();
+        continuous.pop_back();
+        sleeping.pop_back();
+        sleepTime.pop_back();
+        owners.pop_back();
+        transforms.pop_back();
+        handles.pop_back();
+    }
+    
+    // Stops a body from being simulated while its owner is being torn down
+    static void Detach(uint32_t index) {
+        if (index >= owners.size()) return;
+        owners[index] = nullptr;
+        transforms[index] = nullptr;
+    }
+    
+    static size_t Count() { return owners.size(); }
+    
+    // Sleeping bodies keep their state but are skipped by integration
+    static void Sleep(uint32_t index) {
+        sleeping[index] = 1;
+        velX[index] = velY[index] = 0;
+        accX[index] = accY[index] = 0;
+    }
+    
+    static void Wake(uint32_t index) {
+        sleeping[index] = 0;
+        sleepTime[index] = 0;
+    }
+    
+    // Integrates velocities, then positions. PhysicsWorld::Step solves
+    // contacts in between the two halves.
+    static void Integrate(float dt) {
+        IntegrateVelocities(dt);
+        IntegratePositions(dt);
+    }
+    
+    static void IntegrateVelocities(float dt) {
+        JobSystem::ParallelFor(owners.size(), IntegrateBatch, [dt](size_t begin, size_t end, int) {
+            // Gather: pull positions out of the Transforms once per step
+            for (size_t i = begin; i < end; i++) {
+                Component* owner = owners[i];
+                GameObject* obj = owner ? owner->GetGameObject() : nullptr;
+                timeOfImpact[i] = 1.0f;
+                
+                if (!obj || !obj->active || !owner->IsEnabled() || kinematic[i] || sleeping[i]) {
+                    simulate[i] = 0;
+                    transforms[i] = nullptr;
+                    continue;
+                }
+                
+                Transform* tf = obj->transform.get();
+                transforms[i] = tf;
+                posX[i] = prevPosX[i] = tf->position.x;
+                posY[i] = prevPosY[i] = tf->position.y;
+                simulate[i] = 1.0f;
+            }
+            
+            // One branch-free loop over packed lanes
+            IntegrateVelocityLanes(end - begin, dt,
+                velX.data() + begin, velY.data() + begin,
+                prevVelX.data() + begin, prevVelY.data() + begin,
+                accX.data() + begin, accY.data() + begin, drag.data() + begin,
+                gravityAccel.data() + begin, simulate.data() + begin);
+        });
+    }
+    
+    static void IntegratePositions(float dt) {
+        JobSystem::ParallelFor(owners.size(), IntegrateBatch, [dt](size_t begin, size_t end, int) {
+            IntegratePositionLanes(end - begin, dt,
+                posX.data() + begin, posY.data() + begin,
+                velX.data() + begin, velY.data() + begin,
+                simulate.data() + begin, timeOfImpact.data() + begin);
+            
+            // Scatter: write positions back to the Transforms
+            for (size_t i = begin; i < end; i++) {
+                Transform* tf = transforms[i];
+                if (!tf) continue;
+                tf->position.x = posX[i];
+                tf->position.y = posY[i];
+            }
+        });
+    }
+    
+    // Moves the Transforms of bodies simulated last step to alpha between
+    // their previous and current positions, for rendering between ticks.
+    // The current positions are kept in posX/posY until RestoreInterpolation.
+    static void ApplyInterpolation(float alpha) {
+        for (size_t i = 0; i < owners.size(); i++) {
+            Transform* tf = transforms[i];
+            if (!tf) continue;
+            
+            posX[i] = tf->position.x;
+            posY[i] = tf->position.y;
+            tf->position.x = prevPosX[i] + (posX[i] - prevPosX[i]) * alpha;
+            tf->position.y = prevPosY[i] + (posY[i] - prevPosY[i]) * alpha;
+        }
+    }
+    
+    static void RestoreInterpolation() {
+        for (size_t i = 0; i < owners.size(); i++) {
+            Transform* tf = transforms[i];
+            if (!tf) continue;
+            
+            tf->position.x = posX[i];
+            tf->position.y = posY[i];
+        }
+    }
+    
+private:
+    // Lanes are passed as restrict parameters so the loops vectorize
+    static void IntegrateVelocityLanes(size_t n, float dt,
+                                       float* RAYGAME_RESTRICT vx, float* RAYGAME_RESTRICT vy,
+                                       float* RAYGAME_RESTRICT pvx, float* RAYGAME_RESTRICT pvy,
+                                       float* RAYGAME_RESTRICT ax, float* RAYGAME_RESTRICT ay,
+                                       const float* RAYGAME_RESTRICT dg,
+                                       const float* RAYGAME_RESTRICT g,
+                                       const float* RAYGAME_RESTRICT sim) {
+        for (size_t i = 0; i < n; i++) {
+            float s = sim[i];
+            pvx[i] = vx[i];
+            pvy[i] = vy[i];
+            
+            float nvx = (vx[i] + ax[i] * dt) * dg[i];
+            float nvy = (vy[i] + (ay[i] + g[i]) * dt) * dg[i];
+            
+            vx[i] += (nvx - vx[i]) * s;
+            vy[i] += (nvy - vy[i]) * s;
+            
+            // Accumulated forces are consumed by simulated bodies only
+            ax[i] *= 1.0f - s;
+            ay[i] *= 1.0f - s;
+        }
+    }
+    
+    static void IntegratePositionLanes(size_t n, float dt,
+                                       float* RAYGAME_RESTRICT px, float* RAYGAME_RESTRICT py,
+                                       const float* RAYGAME_RESTRICT vx,
+                                       const float* RAYGAME_RESTRICT vy,
+                                       const float* RAYGAME_RESTRICT sim,
+                                       const float* RAYGAME_RESTRICT toi) {
+        for (size_t i = 0; i < n; i++) {
+            float step = dt * sim[i] * toi[i];
+            px[i] += vx[i] * step;
+            py[i] += vy[i] * step;
+        }
+    }
+    
+    template<typename T>
+    static void MoveLane(std::vector<T>& lane, uint32_t to, uint32_t from) {
+        lane[to] = lane[from];
+    }
+};
+
+}
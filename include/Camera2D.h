@@ -29,7 +29,7 @@ public:
     
     void Update() override {
         if (followEnabled && target && target->active) {
-            Vector2 targetPos = target->transform->position;
+            Vector2 targetPos = target->transform->GetWorldPosition();
             Vector2 currentTarget = camera.target;
             
             // Smooth follow
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Core.h"
+#include "GameObject.h"
+
+namespace RayGame {
+
+// Records structural changes (spawning, destroying, adding and removing
+// components) to be applied later, in one batch, by the owning scene.
+// Each thread records into its own buffer, so recording needs no locks and
+// is safe from parallel component updates.
+class RAYGAME_API CommandBuffer {
+public:
+    enum class CommandType { Spawn, Destroy, Modify };
+    
+    struct Command {
+        CommandType type;
+        EntityHandle target;                    // Destroy and Modify
+        std::string name;                       // Spawn
+        std::function<void(GameObject&)> fn;    // Spawn setup or Modify body
+    };
+    
+    // Creates an object at playback and runs setup on it
+    void Spawn(const std::string& name, std::function<void(GameObject&)> setup = nullptr) {
+        commands.push_back({CommandType::Spawn, {}, name, std::move(setup)});
+    }
+    
+    void Destroy(EntityHandle target) {
+        commands.push_back({CommandType::Destroy, target, {}, nullptr});
+    }
+    
+    template<typename T, typename... Args>
+    void AddComponent(EntityHandle target, Args... args) {
+        Modify(target, [args...](GameObject& obj) { obj.AddComponent<T>(args...); });
+    }
+    
+    template<typename T>
+    void RemoveComponent(EntityHandle target) {
+        Modify(target, [](GameObject& obj) { obj.RemoveComponent<T>(); });
+    }
+    
+    // Runs fn on the object at playback; skipped if the handle went stale
+    void Modify(EntityHandle target, std::function<void(GameObject&)> fn) {
+        commands.push_back({CommandType::Modify, target, {}, std::move(fn)});
+    }
+    
+    bool IsEmpty() const { return commands.empty(); }
+    size_t GetCommandCount() const { return commands.size(); }
+    
+    // Keeps capacity for the next frame
+    void Clear() { commands.clear(); }
+
+private:
+    friend class Scene;
+    
+    std::vector<Command> commands;
+};
+
+}
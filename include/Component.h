@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core.h"
+#include "ComponentType.h"
+#include <atomic>
 
 namespace RayGame {
 
@@ -11,24 +13,47 @@ public:
     
     virtual void Start() {}
     virtual void Update() {}
+    virtual void FixedUpdate() {}  // Once per physics tick, before the step
     virtual void Render() {}
     virtual void OnDestroy() {}
     
+    // Physics events, sent to every component on both objects of a pair
+    virtual void OnCollisionEnter(Collider*) {}
+    virtual void OnCollisionStay(Collider*) {}
+    virtual void OnCollisionExit(Collider*) {}
+    virtual void OnTriggerEnter(Collider*) {}
+    virtual void OnTriggerExit(Collider*) {}
+    
     bool IsEnabled() const { return enabled; }
     void SetEnabled(bool value) { enabled = value; }
     
     GameObject* GetGameObject() const { return gameObject; }
     
+    // Start normally waits until the component is enabled; components that
+    // register themselves somewhere (e.g. colliders) start regardless
+    bool ShouldStart() const { return enabled || startWhenDisabled; }
+    
+    // Concrete type this component was added as
+    ComponentTypeId GetTypeId() const { return typeId; }
+    
 protected:
     friend class GameObject;
     GameObject* gameObject;
     bool enabled;
+    bool startWhenDisabled = false;  // Start runs even if disabled at spawn
+    ComponentTypeId typeId = InvalidComponentType;
 };
 
+// Local position, rotation and scale relative to an optional parent.
+// World values are cached together with the sin/cos of the world rotation
+// and recomputed only when this transform's local values or an ancestor's
+// world values have changed since the last time they were read. During a
+// parallel update stage the cache is frozen: getters return the world
+// values from the start of the stage and write nothing.
 class RAYGAME_API Transform : public Component {
 public:
-    Vector2 position = {0, 0};
-    float rotation = 0.0f;  // degrees
+    Vector2 position = {0, 0};  // Relative to the parent; world space for roots
+    float rotation = 0.0f;      // degrees
     Vector2 scale = {1, 1};
     
     Transform() = default;
@@ -36,6 +61,14 @@ public:
     Transform(Vector2 pos, float rot, Vector2 scl) 
         : position(pos), rotation(rot), scale(scl) {}
     
+    // Hierarchy links point at live transforms and aren't copied
+    Transform(const Transform& other) : Component(other) { CopyLocal(other); }
+    Transform& operator=(const Transform& other) {
+        Component::operator=(other);
+        CopyLocal(other);
+        return *this;
+    }
+    
     void Translate(Vector2 offset) {
         position.x += offset.x;
         position.y += offset.y;
@@ -51,13 +84,198 @@ public:
     }
     
     Vector2 Forward() const {
-        float rad = rotation * DEG2RAD;
-        return {std::cos(rad), std::sin(rad)};
+        Refresh();
+        return {world.cos, world.sin};
     }
     
     Vector2 Right() const {
-        float rad = (rotation + 90) * DEG2RAD;
-        return {std::cos(rad), std::sin(rad)};
+        Refresh();
+        return {-world.sin, world.cos};  // Forward turned by 90 degrees
+    }
+    
+    Vector2 GetWorldPosition() const { Refresh(); return world.position; }
+    float GetWorldRotation() const { Refresh(); return world.rotation; }
+    Vector2 GetWorldScale() const { Refresh(); return world.scale; }
+    
+    const Matrix& GetLocalToWorldMatrix() const {
+        Refresh();
+        return world.matrix;
+    }
+    
+    // Local point to world space
+    Vector2 TransformPoint(Vector2 point) const {
+        Refresh();
+        return Apply(world, point);
+    }
+    
+    // World point to local space
+    Vector2 InverseTransformPoint(Vector2 point) const {
+        Refresh();
+        return Unapply(world, point);
+    }
+    
+    Transform* GetParent() const { return parent; }
+    const std::vector<Transform*>& GetChildren() const { return children; }
+    
+    // Attaches to a new parent, or detaches with nullptr. By default the
+    // world pose is kept and the local values are rewritten to match.
+    // Returns false if the new parent is this transform or a descendant.
+    bool SetParent(Transform* newParent, bool keepWorldPose = true) {
+        if (newParent == parent) return true;
+        for (Transform* t = newParent; t; t = t->parent) {
+            if (t == this) return false;
+        }
+        
+        Refresh();
+        World pose = world;
+        
+        if (parent) {
+            auto& siblings = parent->children;
+            siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+        }
+        parent = newParent;
+        if (parent) parent->children.push_back(this);
+        
+        if (keepWorldPose) {
+            if (parent) {
+                parent->Refresh();
+                const World& p = parent->world;
+                position = Unapply(p, pose.position);
+                rotation = pose.rotation - p.rotation;
+                scale = {
+                    p.scale.x != 0 ? pose.scale.x / p.scale.x : 0,
+                    p.scale.y != 0 ? pose.scale.y / p.scale.y : 0
+                };
+            } else {
+                position = pose.position;
+                rotation = pose.rotation;
+                scale = pose.scale;
+            }
+        }
+        valid = false;
+        return true;
+    }
+    
+    // Brings this transform and its subtree up to date in one pass,
+    // parents before children. Scenes run it on every root before each
+    // parallel update stage and once per frame before rendering.
+    void UpdateHierarchy() const {
+        if (Stale()) Recompute();
+        for (Transform* child : children) {
+            child->UpdateHierarchy();
+        }
+    }
+    
+    // Children stay where they are in the world and become roots
+    void OnDestroy() override {
+        while (!children.empty()) {
+            children.back()->SetParent(nullptr);
+        }
+        SetParent(nullptr, false);
+    }
+    
+    // Set by the scene around parallel update stages. Refreshing would
+    // write this transform's cache and its ancestors', which belong to
+    // other objects, so while frozen the getters only read.
+    static void SetCacheFrozen(bool value) { cacheFrozen.store(value, std::memory_order_relaxed); }
+    static bool IsCacheFrozen() { return cacheFrozen.load(std::memory_order_relaxed); }
+    
+private:
+    struct World {
+        Vector2 position = {0, 0};
+        float rotation = 0.0f;
+        Vector2 scale = {1, 1};
+        float sin = 0.0f;
+        float cos = 1.0f;
+        Matrix matrix = MatrixIdentity();
+    };
+    
+    Transform* parent = nullptr;
+    std::vector<Transform*> children;
+    
+    // Cache, filled lazily from const getters
+    mutable World world;
+    mutable Vector2 cachedPosition = {0, 0};  // Local values the cache was built from
+    mutable float cachedRotation = 0.0f;
+    mutable Vector2 cachedScale = {1, 1};
+    mutable uint32_t version = 0;             // Bumped on every recompute
+    mutable uint32_t parentVersion = 0;       // Parent's version at the last recompute
+    mutable bool valid = false;
+    
+    static inline std::atomic<bool> cacheFrozen{false};
+    
+    void CopyLocal(const Transform& other) {
+        position = other.position;
+        rotation = other.rotation;
+        scale = other.scale;
+        valid = false;
+    }
+    
+    bool Stale() const {
+        return !valid
+            || position.x != cachedPosition.x || position.y != cachedPosition.y
+            || rotation != cachedRotation
+            || scale.x != cachedScale.x || scale.y != cachedScale.y
+            || (parent && parentVersion != parent->version);
+    }
+    
+    void Refresh() const {
+        if (IsCacheFrozen()) return;
+        if (parent) parent->Refresh();
+        if (Stale()) Recompute();
+    }
+    
+    void Recompute() const {
+        if (parent) {
+            const World& p = parent->world;
+            world.position = Apply(p, position);
+            world.rotation = p.rotation + rotation;
+            world.scale = {p.scale.x * scale.x, p.scale.y * scale.y};
+            parentVersion = parent->version;
+        } else {
+            world.position = position;
+            world.rotation = rotation;
+            world.scale = scale;
+        }
+        
+        float rad = world.rotation * DEG2RAD;
+        world.sin = std::sin(rad);
+        world.cos = std::cos(rad);
+        
+        Matrix& m = world.matrix;
+        m = MatrixIdentity();
+        m.m0 = world.cos * world.scale.x;
+        m.m1 = world.sin * world.scale.x;
+        m.m4 = -world.sin * world.scale.y;
+        m.m5 = world.cos * world.scale.y;
+        m.m12 = world.position.x;
+        m.m13 = world.position.y;
+        
+        cachedPosition = position;
+        cachedRotation = rotation;
+        cachedScale = scale;
+        version++;
+        valid = true;
+    }
+    
+    static Vector2 Apply(const World& w, Vector2 p) {
+        float x = p.x * w.scale.x;
+        float y = p.y * w.scale.y;
+        return {
+            w.position.x + x * w.cos - y * w.sin,
+            w.position.y + x * w.sin + y * w.cos
+        };
+    }
+    
+    static Vector2 Unapply(const World& w, Vector2 p) {
+        float dx = p.x - w.position.x;
+        float dy = p.y - w.position.y;
+        float x = dx * w.cos + dy * w.sin;
+        float y = -dx * w.sin + dy * w.cos;
+        return {
+            w.scale.x != 0 ? x / w.scale.x : 0,
+            w.scale.y != 0 ? y / w.scale.y : 0
+        };
     }
 };
 
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "Core.h"
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace RayGame {
+
+using ComponentTypeId = uint32_t;
+
+constexpr ComponentTypeId InvalidComponentType = 0xFFFFFFFFu;
+
+// Direct call into one concrete type's override (virtual only when the
+// override isn't accessible from outside the type)
+using ComponentCallback = void (*)(Component*);
+
+// Component types a component's Update/FixedUpdate reads or writes on its
+// own object, besides itself. Declare it with a static member:
+//
+//     static void DeclareAccess(ComponentAccess& access) {
+//         access.Write<Transform>();
+//         access.Read<Rigidbody>();
+//     }
+//
+// Declaring access also promises that the update touches no other objects,
+// globals or scene structure, so the scene may run it on worker threads
+// alongside other types it doesn't conflict with. Creating, destroying and
+// adding or removing components go through the scene's command buffer
+// (Scene::GetCommandBuffer) instead. Types without a declaration always
+// run on the main thread, in order.
+//
+// Transform world getters (GetWorldPosition, Forward, TransformPoint, ...)
+// depend on every ancestor. The scene brings all hierarchies up to date
+// before each parallel stage and freezes the world cache while it runs, so
+// Read<Transform> may use them safely; they return the world values from
+// the start of the stage, even after a Write<Transform> update changed the
+// local ones.
+struct ComponentAccess {
+    std::vector<ComponentTypeId> reads;
+    std::vector<ComponentTypeId> writes;
+    
+    template<typename T> void Read();
+    template<typename T> void Write();
+};
+
+struct ComponentTypeInfo {
+    const char* name = "";                  // Compiler-specific, for debugging
+    ComponentCallback update = nullptr;     // Null unless the type overrides Update
+    ComponentCallback fixedUpdate = nullptr;
+    ComponentCallback render = nullptr;
+    bool declaresAccess = false;
+    ComponentAccess access;                 // Includes a write of the type itself
+};
+
+// Dense ids for concrete component types, handed out on first use.
+// Ids index archetype signatures and per-type lookup tables. Each type also
+// records which of Update/FixedUpdate/Render it overrides, so a scene only
+// dispatches to types that do real work.
+class RAYGAME_API ComponentTypes {
+public:
+    template<typename T>
+    static ComponentTypeId Id() {
+        static const ComponentTypeId id = Register(Describe<T>());
+        return id;
+    }
+    
+    static size_t Count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return types.size();
+    }
+    
+    static ComponentTypeInfo GetInfo(ComponentTypeId id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return id < types.size() ? types[id] : ComponentTypeInfo();
+    }
+    
+    static const char* GetName(ComponentTypeId id) {
+        return GetInfo(id).name;
+    }
+
+private:
+    static inline std::mutex mutex;
+    static inline std::vector<ComponentTypeInfo> types;
+    
+    static ComponentTypeId Register(ComponentTypeInfo info) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ComponentTypeId id = (ComponentTypeId)types.size();
+        if (info.declaresAccess) info.access.writes.push_back(id);  // Own id is known only now
+        types.push_back(std::move(info));
+        return id;
+    }
+    
+    // Deduces the class that declares the nullary overload a member name
+    // resolves to; Component itself means the type doesn't override it
+    template<typename C>
+    static C* DeclaredIn(void (C::*)());
+    
+    // Whether T overrides a callback, found without calling it. Taking the
+    // member's address fails (and is treated as Unknown) when the override
+    // is private or the name is overloaded; those go through the virtual.
+    enum class Override { No, Yes, Unknown };
+    
+    template<typename Declarer>
+    static constexpr Override OverrideFrom() {
+        return std::is_same<Declarer, Component*>::value ? Override::No : Override::Yes;
+    }
+    
+    // Component is still incomplete here; naming it through T defers the
+    // virtual call until Describe is instantiated
+    template<typename T>
+    static std::conditional_t<std::is_class<T>::value, Component, T>* AsComponent(Component* c) {
+        return c;
+    }
+    
+    template<typename T, typename = void>
+    struct UpdateOverride { static constexpr Override value = Override::Unknown; };
+    template<typename T>
+    struct UpdateOverride<T, std::void_t<decltype(DeclaredIn(&T::Update))>> {
+        static constexpr Override value = OverrideFrom<decltype(DeclaredIn(&T::Update))>();
+    };
+    
+    template<typename T, typename = void>
+    struct FixedUpdateOverride { static constexpr Override value = Override::Unknown; };
+    template<typename T>
+    struct FixedUpdateOverride<T, std::void_t<decltype(DeclaredIn(&T::FixedUpdate))>> {
+        static constexpr Override value = OverrideFrom<decltype(DeclaredIn(&T::FixedUpdate))>();
+    };
+    
+    template<typename T, typename = void>
+    struct RenderOverride { static constexpr Override value = Override::Unknown; };
+    template<typename T>
+    struct RenderOverride<T, std::void_t<decltype(DeclaredIn(&T::Render))>> {
+        static constexpr Override value = OverrideFrom<decltype(DeclaredIn(&T::Render))>();
+    };
+    
+    template<typename T, typename = void>
+    struct HasDeclareAccess : std::false_type {};
+    
+    template<typename T>
+    struct HasDeclareAccess<T, std::void_t<decltype(T::DeclareAccess(std::declval<ComponentAccess&>()))>>
+        : std::true_type {};
+    
+    template<typename T>
+    static ComponentTypeInfo Describe() {
+        ComponentTypeInfo info;
+        info.name = typeid(T).name();
+        
+        if constexpr (UpdateOverride<T>::value == Override::Yes) {
+            info.update = [](Component* c) { static_cast<T*>(c)->T::Update(); };
+        } else if constexpr (UpdateOverride<T>::value == Override::Unknown) {
+            info.update = [](Component* c) { AsComponent<T>(c)->Update(); };
+        }
+        if constexpr (FixedUpdateOverride<T>::value == Override::Yes) {
+            info.fixedUpdate = [](Component* c) { static_cast<T*>(c)->T::FixedUpdate(); };
+        } else if constexpr (FixedUpdateOverride<T>::value == Override::Unknown) {
+            info.fixedUpdate = [](Component* c) { AsComponent<T>(c)->FixedUpdate(); };
+        }
+        if constexpr (RenderOverride<T>::value == Override::Yes) {
+            info.render = [](Component* c) { static_cast<T*>(c)->T::Render(); };
+        } else if constexpr (RenderOverride<T>::value == Override::Unknown) {
+            info.render = [](Component* c) { AsComponent<T>(c)->Render(); };
+        }
+        if constexpr (HasDeclareAccess<T>::value) {
+            info.declaresAccess = true;
+            T::DeclareAccess(info.access);
+        }
+        return info;
+    }
+};
+
+template<typename T>
+void ComponentAccess::Read() {
+    reads.push_back(ComponentTypes::Id<T>());
+}
+
+template<typename T>
+void ComponentAccess::Write() {
+    writes.push_back(ComponentTypes::Id<T>());
+}
+
+}
@@ -21,13 +21,22 @@
     #define RAYGAME_API
 #endif
 
+// Pointer aliasing hint for tight loops over packed arrays
+#ifdef _MSC_VER
+    #define RAYGAME_RESTRICT __restrict
+#else
+    #define RAYGAME_RESTRICT __restrict__
+#endif
+
 // Forward declarations
 namespace RayGame {
     class GameObject;
     class Component;
     class Transform;
+    class Collider;
     class Scene;
     class GameEngine;
+    class ArchetypeStorage;
     
     // Smart pointer types
     template<typename T>
@@ -53,19 +62,6 @@ namespace RayGame {
         return value;
     }
     
-    inline float Random(float min, float max) {
-        // Use raylib's GetRandomValue for better reliability
-        // Get random int in range 0-10000, then scale to float range
-        if (min >= max) return min;
-        int randomInt = GetRandomValue(0, 10000);
-        float normalized = static_cast<float>(randomInt) / 10000.0f;
-        return min + normalized * (max - min);
-    }
-    
-    inline Vector2 Random(const Vector2& min, const Vector2& max) {
-        return { Random(min.x, max.x), Random(min.y, max.y) };
-    }
-    
     inline float Distance(const Vector2& a, const Vector2& b) {
         float dx = b.x - a.x;
         float dy = b.y - a.y;
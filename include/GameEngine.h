@@ -6,6 +6,7 @@
 #include "Input.h"
 #include "ResourceManager.h"
 #include "Physics.h"
+#include "JobSystem.h"
 
 namespace RayGame {
 
@@ -16,6 +17,9 @@ public:
         currentScene = nullptr;
         running = false;
         showDebug = false;
+        accumulator = 0.0f;
+        maxSubsteps = 5;
+        interpolate = true;
     }
     
     virtual ~GameEngine() = default;
@@ -26,6 +30,7 @@ public:
         
         AudioManager::Init();
         ResourceManager::Init();
+        JobSystem::Init();
         
         OnInit();
     }
@@ -54,8 +59,10 @@ public:
         }
         
         PhysicsWorld::Clear();
+        JobSystem::Shutdown();
         ResourceManager::Shutdown();
         AudioManager::Shutdown();
+        ParticleRenderer::Shutdown();
         
         CloseWindow();
     }
@@ -79,6 +86,20 @@ public:
     
     void Quit() { running = false; }
     
+    // Physics and FixedUpdate run at a fixed rate, independent of frame rate
+    void SetTickRate(float hz) { GameTime::SetFixedDeltaTime(1.0f / hz); }
+    float GetTickRate() const { return 1.0f / GameTime::FixedDeltaTime(); }
+    
+    // Ticks allowed per frame; time beyond that is dropped so a slow frame
+    // can't snowball into ever more ticks
+    void SetMaxSubsteps(int value) { maxSubsteps = std::max(1, value); }
+    
+    // Render rigidbodies between their last two physics states
+    void SetInterpolation(bool value) { interpolate = value; }
+    
+    // How far the current frame is into the next tick, 0..1
+    float GetInterpolationAlpha() const { return accumulator / GameTime::FixedDeltaTime(); }
+    
     void ToggleDebug() { showDebug = !showDebug; }
     bool IsDebugEnabled() const { return showDebug; }
     
@@ -93,6 +114,9 @@ private:
     Ref<Scene> currentScene;
     bool running;
     bool showDebug;
+    float accumulator;
+    int maxSubsteps;
+    bool interpolate;
     
     void Update() {
         GameTime::Update();
@@ -107,12 +131,37 @@ private:
             currentScene->Update();
         }
         
-        PhysicsWorld::CheckCollisions();
+        FixedUpdate();
         
         OnUpdate();
     }
     
+    void FixedUpdate() {
+        const float fixedDelta = GameTime::FixedDeltaTime();
+        accumulator += GameTime::DeltaTime();
+        
+        int steps = 0;
+        while (accumulator >= fixedDelta && steps < maxSubsteps) {
+            if (currentScene) {
+                currentScene->FixedUpdate();
+            }
+            PhysicsWorld::Step(fixedDelta);
+            
+            accumulator -= fixedDelta;
+            steps++;
+        }
+        
+        // Behind by more than the substep budget: drop the backlog
+        if (accumulator >= fixedDelta) {
+            accumulator = std::fmod(accumulator, fixedDelta);
+        }
+    }
+    
     void Render() {
+        if (interpolate) {
+            BodyStorage::ApplyInterpolation(GetInterpolationAlpha());
+        }
+        
         BeginDrawing();
         ClearBackground(BLACK);
         
@@ -129,10 +178,27 @@ private:
                 currentScene ? currentScene->GetAllGameObjects().size() : 0), 
                 10, 30, 20, YELLOW);
             
+            const PhysicsStats& stats = PhysicsWorld::GetStats();
+            DrawText(TextFormat("Pairs: %d tested / %d hit", 
+                stats.pairsTested, stats.pairsHit), 
+                10, 50, 20, YELLOW);
+            DrawText(TextFormat("Sleeping: %d bodies / %d idle colliders", 
+                stats.sleepingBodies, stats.idleColliders), 
+                10, 70, 20, YELLOW);
+            
+            const ParticleRenderStats& particles = ParticleRenderer::GetStats();
+            DrawText(TextFormat("Particles: %d in %d batches", 
+                particles.quads, particles.batches), 
+                10, 90, 20, YELLOW);
+            
             PhysicsWorld::DebugDraw();
         }
         
         EndDrawing();
+        
+        if (interpolate) {
+            BodyStorage::RestoreInterpolation();
+        }
     }
 };
 
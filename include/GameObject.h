@@ -2,24 +2,34 @@
 
 #include "Core.h"
 #include "Component.h"
+#include "StringId.h"
+#include "PoolAllocator.h"
 
 namespace RayGame {
 
+// Names a scene slot; the generation tells a reused slot from the object
+// that held it before
+struct EntityHandle {
+    uint32_t index = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+    
+    bool operator==(const EntityHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
 class RAYGAME_API GameObject {
 public:
-    std::string name;
-    std::string tag;
     bool active = true;
     
     GameObject(const std::string& name = "GameObject") 
-        : name(name), tag("Default") {
+        : name(name), tag(DefaultTag()) {
         transform = AddComponent<Transform>();
     }
     
     virtual ~GameObject() {
-        for (auto& comp : components) {
-            comp->OnDestroy();
-        }
+        DestroyComponents();
     }
     
     template<typename T, typename... Args>
@@ -27,21 +37,71 @@ public:
         static_assert(std::is_base_of<Component, T>::value, 
                      "T must derive from Component");
         
-        auto component = CreateRef<T>(std::forward<Args>(args)...);
+        // From T's block pool, not the global heap
+        auto component = CreatePooledRef<T>(std::forward<Args>(args)...);
         component->gameObject = this;
+        component->typeId = ComponentTypes::Id<T>();
         components.push_back(component);
+        IndexComponent(component.get());
+        OnComponentsChanged();
+        
+        // Components added to a running object start right away
+        if (started && component->ShouldStart()) {
+            component->Start();
+        }
         return component;
     }
     
+    // Exact component types resolve with one indexed load. Base-class
+    // queries (e.g. Collider) fall back to a dynamic_cast scan.
     template<typename T>
-    Ref<T> GetComponent() {
+    T* GetComponent() const {
+        static_assert(std::is_base_of<Component, T>::value, 
+                     "T must derive from Component");
+        
+        ComponentTypeId id = ComponentTypes::Id<T>();
+        if (id < componentsByType.size() && componentsByType[id]) {
+            return static_cast<T*>(componentsByType[id]);
+        }
+        
         for (auto& comp : components) {
-            auto casted = std::dynamic_pointer_cast<T>(comp);
-            if (casted) return casted;
+            if (T* casted = dynamic_cast<T*>(comp.get())) return casted;
         }
         return nullptr;
     }
     
+    // Owning handle, for code that needs to keep the component alive
+    template<typename T>
+    Ref<T> GetComponentRef() const {
+        T* component = GetComponent<T>();
+        if (!component) return nullptr;
+        
+        for (auto& comp : components) {
+            if (comp.get() == component) return std::static_pointer_cast<T>(comp);
+        }
+        return nullptr;
+    }
+    
+    // Removes the first component of type T; the transform always stays
+    template<typename T>
+    bool RemoveComponent() {
+        static_assert(std::is_base_of<Component, T>::value, 
+                     "T must derive from Component");
+        
+        for (auto it = components.begin(); it != components.end(); ++it) {
+            if ((*it).get() == transform.get()) continue;
+            if (!std::dynamic_pointer_cast<T>(*it)) continue;
+            
+            Ref<Component> removed = *it;
+            components.erase(it);
+            ReindexComponents();
+            removed->OnDestroy();
+            OnComponentsChanged();
+            return true;
+        }
+        return false;
+    }
+    
     template<typename T>
     std::vector<Ref<T>> GetComponents() {
         std::vector<Ref<T>> result;
@@ -53,16 +113,44 @@ public:
     }
     
     void Start() {
-        for (auto& comp : components) {
-            if (comp->IsEnabled()) {
-                comp->Start();
+        if (started) return;
+        
+        // Index-based: components added from Start are picked up by this loop
+        for (size_t i = 0; i < components.size(); i++) {
+            if (components[i]->ShouldStart()) {
+                components[i]->Start();
             }
         }
+        started = true;
+    }
+    
+    bool IsStarted() const { return started; }
+    
+    // Names and tags are interned; changing them keeps the scene's
+    // name and tag indices up to date
+    StringId GetName() const { return name; }
+    StringId GetTag() const { return tag; }
+    bool CompareTag(StringId value) const { return tag == value; }
+    void SetName(StringId value);
+    void SetTag(StringId value);
+    
+    static StringId DefaultTag() {
+        static const StringId value("Default");
+        return value;
     }
     
+    // Slot in the owning scene; compare with Scene::IsValid before use
+    EntityHandle GetHandle() const { return handle; }
+    
+    // Null once released from its scene
+    Scene* GetScene() const { return scene; }
+    
     void Update() {
         if (!active) return;
         
+        // Objects created after the scene started get Start before their first Update
+        if (!started) Start();
+        
         // Use index-based loop to avoid iterator invalidation
         for (size_t i = 0; i < components.size(); i++) {
             if (components[i] && components[i]->IsEnabled()) {
@@ -71,6 +159,16 @@ public:
         }
     }
     
+    void FixedUpdate() {
+        if (!active || !started) return;
+        
+        for (size_t i = 0; i < components.size(); i++) {
+            if (components[i] && components[i]->IsEnabled()) {
+                components[i]->FixedUpdate();
+            }
+        }
+    }
+    
     void Render() {
         if (!active) return;
         
@@ -82,10 +180,76 @@ public:
         }
     }
     
-    Ref<Transform> transform;
+    const std::vector<Ref<Component>>& GetAllComponents() const {
+        return components;
+    }
     
+    Ref<Transform> transform;
+
 private:
+    friend class ArchetypeStorage;
+    friend class Scene;
+    
+    StringId name;
+    StringId tag;
+    
     std::vector<Ref<Component>> components;
+    std::vector<Component*> componentsByType;  // First component of each exact type, by type id
+    bool started = false;
+    
+    // Placement in the owning scene's ArchetypeStorage, if any
+    ArchetypeStorage* storage = nullptr;
+    uint32_t archetypeIndex = 0xFFFFFFFFu;
+    uint32_t archetypeRow = 0;
+    bool queued = false;
+    
+    // Placement in the owning scene's slot map and name/tag indices
+    Scene* scene = nullptr;
+    EntityHandle handle;
+    uint32_t nameSlot = 0;
+    uint32_t tagSlot = 0;
+    
+    void OnComponentsChanged();
+    void LeaveStorage();
+    
+    void IndexComponent(Component* component) {
+        ComponentTypeId id = component->GetTypeId();
+        if (id >= componentsByType.size()) componentsByType.resize(id + 1, nullptr);
+        if (!componentsByType[id]) componentsByType[id] = component;
+    }
+    
+    // Sends OnDestroy and drops every component, transform included
+    void DestroyComponents() {
+        LeaveStorage();
+        
+        for (auto& comp : components) {
+            comp->OnDestroy();
+        }
+        components.clear();
+        std::fill(componentsByType.begin(), componentsByType.end(), nullptr);
+    }
+    
+    // Returns a pooled object to the state of a freshly constructed one,
+    // keeping its Transform allocation
+    void Reset(const std::string& newName) {
+        name = newName;
+        tag = DefaultTag();
+        active = true;
+        started = false;
+        
+        *transform = Transform();
+        transform->gameObject = this;
+        transform->typeId = ComponentTypes::Id<Transform>();
+        components.push_back(transform);
+        IndexComponent(transform.get());
+    }
+    
+    void ReindexComponents() {
+        std::fill(componentsByType.begin(), componentsByType.end(), nullptr);
+        for (auto& comp : components) {
+            IndexComponent(comp.get());
+        }
+    }
 };
 
 }
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Core.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace RayGame {
+
+// Jobs with dependencies, run by JobSystem::Run. A job may only depend on
+// jobs added before it, so insertion order is always a valid serial order.
+class RAYGAME_API JobGraph {
+public:
+    using JobId = uint32_t;
+    
+    static constexpr JobId InvalidJob = 0xFFFFFFFFu;
+    
+    // Rejects the job (returning InvalidJob) if it depends on a job that
+    // isn't in the graph yet, rather than letting it run too early. Jobs
+    // depending on a rejected job are rejected in turn.
+    JobId Add(std::function<void()> fn, std::initializer_list<JobId> dependsOn = {}) {
+        JobId id = (JobId)nodes.size();
+        for (JobId dependency : dependsOn) {
+            if (dependency >= id) {
+                TraceLog(LOG_WARNING, "JobGraph: job %u depends on unknown job %u, rejected", id, dependency);
+                return InvalidJob;
+            }
+        }
+        
+        nodes.push_back({std::move(fn), {}, 0});
+        for (JobId dependency : dependsOn) {
+            nodes[dependency].successors.push_back(id);
+            nodes[id].dependencies++;
+        }
+        return id;
+    }
+    
+    void Clear() { nodes.clear(); }
+    size_t GetJobCount() const { return nodes.size(); }
+
+private:
+    friend class JobSystem;
+    
+    struct Node {
+        std::function<void()> fn;
+        std::vector<JobId> successors;
+        uint32_t dependencies;
+    };
+    
+    std::vector<Node> nodes;
+};
+
+// Work-stealing pool of worker threads. Every thread owns a task queue:
+// it pushes and pops work at the back of its own queue and, when that runs
+// dry, steals from the front of the others. Threads waiting for their own
+// work to finish run queued tasks meanwhile, so jobs can nest freely.
+class RAYGAME_API JobSystem {
+public:
+    // threadCount includes the calling thread; 0 uses every hardware thread
+    static void Init(int threadCount = 0) {
+        if (!workers.empty()) return;
+        
+        if (threadCount <= 0) {
+            threadCount = (int)std::thread::hardware_concurrency();
+        }
+        threadCount = std::max(1, threadCount);
+        
+        queues.clear();
+        for (int i = 0; i < threadCount; i++) {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+        
+        stopping = false;
+        for (int i = 1; i < threadCount; i++) {
+            workers.emplace_back(WorkerLoop, i);
+        }
+    }
+    
+    static void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        queues.clear();
+    }
+    
+    // Workers plus the calling thread
+    static int GetThreadCount() { return (int)workers.size() + 1; }
+    
+    // Index of the current thread, below GetThreadCount(); 0 off the pool
+    static int GetThreadIndex() { return threadIndex; }
+    
+    // Deterministic mode runs every job inline on the calling thread, in
+    // submission order. Meant for debugging; toggle between frames.
+    static void SetDeterministic(bool value) { deterministic = value; }
+    static bool IsDeterministic() { return deterministic; }
+    
+    // Calls fn(begin, end, threadIndex) over [0, count) in batches of
+    // batchSize, and returns once every batch has run. threadIndex can pick
+    // a per-thread buffer; a thread that waits on a nested ParallelFor may
+    // run other batches meanwhile, so don't hold such a buffer across one.
+    template<typename F>
+    static void ParallelFor(size_t count, size_t batchSize, F&& fn) {
+        if (count == 0) return;
+        
+        batchSize = std::max<size_t>(1, batchSize);
+        size_t batches = (count + batchSize - 1) / batchSize;
+        if (workers.empty() || batches == 1 || deterministic) {
+            fn(size_t(0), count, threadIndex);
+            return;
+        }
+        
+        using Fn = std::remove_reference_t<F>;
+        Counter pending{batches};
+        
+        // Counted before they become visible, so takers never see it drop below zero
+        queuedTasks.fetch_add(batches);
+        WorkQueue& queue = *queues[threadIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (size_t batch = 0; batch < batches; batch++) {
+                size_t begin = batch * batchSize;
+                queue.tasks.push_back({
+                    [](void* context, size_t begin, size_t end, int thread) {
+                        (*static_cast<Fn*>(context))(begin, end, thread);
+                    },
+                    (void*)&fn, begin, std::min(count, begin + batchSize), &pending
+                });
+            }
+        }
+        WakeWorkers(batches);
+        Wait(pending);
+    }
+    
+    // Runs a job graph and returns once every job has finished
+    static void Run(JobGraph& graph) {
+        size_t count = graph.nodes.size();
+        if (count == 0) return;
+        
+        if (workers.empty() || deterministic) {
+            for (auto& node : graph.nodes) {
+                node.fn();
+            }
+            return;
+        }
+        
+        GraphRun run{&graph, std::make_unique<std::atomic<uint32_t>[]>(count), {count}};
+        for (size_t i = 0; i < count; i++) {
+            run.remaining[i] = graph.nodes[i].dependencies;
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            if (graph.nodes[i].dependencies == 0) {
+                Push({RunGraphNode, &run, i, i + 1, &run.pending});
+            }
+        }
+        Wait(run.pending);
+    }
+
+private:
+    using Counter = std::atomic<size_t>;
+    
+    struct Task {
+        void (*invoke)(void* context, size_t begin, size_t end, int thread);
+        void* context;
+        size_t begin;
+        size_t end;
+        Counter* pending;  // Decremented once the task has run
+    };
+    
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    struct GraphRun {
+        JobGraph* graph;
+        std::unique_ptr<std::atomic<uint32_t>[]> remaining;  // Unfinished dependencies per job
+        Counter pending;                                      // Unfinished jobs
+    };
+    
+    static inline std::vector<std::thread> workers;
+    static inline std::vector<std::unique_ptr<WorkQueue>> queues;  // One per thread, calling thread first
+    static inline std::atomic<size_t> queuedTasks{0};
+    static inline std::mutex sleepMutex;
+    static inline std::condition_variable wake;
+    static inline bool stopping = false;
+    static inline bool deterministic = false;
+    
+    static inline thread_local int threadIndex = 0;
+    
+    static void Push(const Task& task) {
+        queuedTasks.fetch_add(1);
+        WorkQueue& queue = *queues[threadIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        WakeWorkers(1);
+    }
+    
+    static void WakeWorkers(size_t added) {
+        // Taking the lock orders this with a worker's check before it sleeps
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        if (added == 1) wake.notify_one();
+        else wake.notify_all();
+    }
+    
+    // Own queue from the back (most recent, still in cache), then steal
+    // from the front of the others
+    static bool TakeTask(int thread, Task& task) {
+        {
+            WorkQueue& own = *queues[thread];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                queuedTasks.fetch_sub(1);
+                return true;
+            }
+        }
+        
+        size_t count = queues.size();
+        for (size_t i = 1; i < count; i++) {
+            WorkQueue& victim = *queues[(thread + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                queuedTasks.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    static bool RunOne(int thread) {
+        Task task;
+        if (!TakeTask(thread, task)) return false;
+        
+        task.invoke(task.context, task.begin, task.end, thread);
+        task.pending->fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+    
+    // Helps out until every task counted by pending has run
+    static void Wait(Counter& pending) {
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!RunOne(threadIndex)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    
+    static void RunGraphNode(void* context, size_t index, size_t, int) {
+        GraphRun& run = *static_cast<GraphRun*>(context);
+        JobGraph::Node& node = run.graph->nodes[index];
+        node.fn();
+        
+        for (JobGraph::JobId successor : node.successors) {
+            if (run.remaining[successor].fetch_sub(1) == 1) {
+                Push({RunGraphNode, &run, successor, successor + 1, &run.pending});
+            }
+        }
+    }
+    
+    static void WorkerLoop(int index) {
+        threadIndex = index;
+        
+        while (true) {
+            if (RunOne(index)) continue;
+            
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [] { return stopping || queuedTasks.load() > 0; });
+            if (stopping) return;
+        }
+    }
+};
+
+}
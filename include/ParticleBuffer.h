@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Core.h"
+
+namespace RayGame {
+
+// Live particles of one emitter as packed structure-of-arrays lanes. Every
+// index below Count() is alive: dead particles are swapped out with the
+// last one, so the lanes never need compacting and never hold holes.
+class RAYGAME_API ParticleBuffer {
+public:
+    // Hot lanes, touched by Update every frame
+    std::vector<float> posX, posY;
+    std::vector<float> velX, velY;
+    std::vector<float> age;
+    std::vector<float> rotation;
+    std::vector<float> rotationSpeed;
+    
+    // Set on emission, read-only afterwards
+    std::vector<float> lifetime;
+    std::vector<float> size;
+    
+    size_t Count() const { return lifetime.size(); }
+    
+    void Reserve(size_t capacity) {
+        posX.reserve(capacity); posY.reserve(capacity);
+        velX.reserve(capacity); velY.reserve(capacity);
+        age.reserve(capacity);
+        rotation.reserve(capacity);
+        rotationSpeed.reserve(capacity);
+        lifetime.reserve(capacity);
+        size.reserve(capacity);
+    }
+    
+    void Add(Vector2 position, Vector2 velocity, float particleLifetime,
+             float particleSize, float particleRotation, float particleRotationSpeed) {
+        posX.push_back(position.x); posY.push_back(position.y);
+        velX.push_back(velocity.x); velY.push_back(velocity.y);
+        age.push_back(0);
+        rotation.push_back(particleRotation);
+        rotationSpeed.push_back(particleRotationSpeed);
+        lifetime.push_back(particleLifetime);
+        size.push_back(particleSize);
+    }
+    
+    // Swap-with-last; the particle that was last now lives at index
+    void Kill(size_t index) {
+        size_t last = Count() - 1;
+        if (index != last) {
+            posX[index] = posX[last]; posY[index] = posY[last];
+            velX[index] = velX[last]; velY[index] = velY[last];
+            age[index] = age[last];
+            rotation[index] = rotation[last];
+            rotationSpeed[index] = rotationSpeed[last];
+            lifetime[index] = lifetime[last];
+            size[index] = size[last];
+        }
+        
+        posX.pop_back(); posY.pop_back();
+        velX.pop_back(); velY.pop_back();
+        age.pop_back();
+        rotation.pop_back();
+        rotationSpeed.pop_back();
+        lifetime.pop_back();
+        size.pop_back();
+    }
+    
+    void Clear() {
+        posX.clear(); posY.clear();
+        velX.clear(); velY.clear();
+        age.clear();
+        rotation.clear();
+        rotationSpeed.clear();
+        lifetime.clear();
+        size.clear();
+    }
+    
+    // Ages and moves every particle under a shared acceleration, then
+    // kills the ones that outlived their lifetime. Returns how many died.
+    size_t Update(float dt, Vector2 acceleration) {
+        Integrate(0, Count(), dt, acceleration);
+        return RemoveExpired();
+    }
+    
+    // Ages and moves particles [begin, end). Disjoint ranges may run on
+    // different threads at once.
+    void Integrate(size_t begin, size_t end, float dt, Vector2 acceleration) {
+        if (begin >= end) return;
+        
+        IntegrateLanes(end - begin, dt, acceleration.x, acceleration.y,
+            posX.data() + begin, posY.data() + begin,
+            velX.data() + begin, velY.data() + begin,
+            age.data() + begin, rotation.data() + begin, rotationSpeed.data() + begin);
+    }
+    
+    // Kills every particle that outlived its lifetime; returns how many
+    size_t RemoveExpired() {
+        size_t n = Count();
+        
+        // Walking backwards, the swapped-in last particle was already checked
+        for (size_t i = n; i-- > 0;) {
+            if (age[i] >= lifetime[i]) Kill(i);
+        }
+        return n - Count();
+    }
+    
+    // 0 when emitted, 1 at the end of its lifetime
+    float GetLifeFraction(size_t index) const {
+        return age[index] / lifetime[index];
+    }
+
+private:
+    // Lanes are passed as restrict parameters so the loop vectorizes
+    static void IntegrateLanes(size_t n, float dt, float ax, float ay,
+                               float* RAYGAME_RESTRICT px, float* RAYGAME_RESTRICT py,
+                               float* RAYGAME_RESTRICT vx, float* RAYGAME_RESTRICT vy,
+                               float* RAYGAME_RESTRICT ages,
+                               float* RAYGAME_RESTRICT rot,
+                               const float* RAYGAME_RESTRICT rotSpeed) {
+        for (size_t i = 0; i < n; i++) {
+            ages[i] += dt;
+            vx[i] += ax * dt;
+            vy[i] += ay * dt;
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            rot[i] += rotSpeed[i] * dt;
+        }
+    }
+};
+
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Core.h"
+#include "ParticleBuffer.h"
+#include <rlgl.h>
+
+namespace RayGame {
+
+enum class ParticleBlend {
+    Alpha,
+    Additive
+};
+
+// What the last Flush drew
+struct ParticleRenderStats {
+    int emitters = 0;   // Submissions
+    int batches = 0;    // Texture + blend groups, one draw call each unless rlgl's buffer fills
+    int quads = 0;
+    int vertices = 0;
+};
+
+// Draws particles as textured quads through rlgl's vertex buffer instead
+// of tessellating a circle per particle. Emitters submit during Render;
+// Flush then draws every submission sharing a texture and blend mode as
+// one group, so a scene's particles cost a handful of draw calls. Scene
+// flushes after its Render dispatch, so particles draw over other components.
+class RAYGAME_API ParticleRenderer {
+public:
+    // Quads written between batch limit checks
+    static constexpr size_t QuadsPerChunk = 1024;
+    
+    // Queues a buffer until Flush; it must stay alive and unchanged until
+    // then. texture.id 0 uses the shared soft-circle texture. rotate turns
+    // each quad by its particle's rotation (pointless for round textures).
+    static void Submit(const ParticleBuffer& particles, Color color, Texture2D texture,
+                       ParticleBlend blend = ParticleBlend::Alpha, bool rotate = false) {
+        if (particles.Count() == 0) return;
+        
+        unsigned int textureId = texture.id;
+        if (textureId == 0 && !headless) textureId = GetSoftCircleTexture().id;
+        
+        Batch* batch = nullptr;
+        for (Batch& candidate : batches) {
+            if (candidate.textureId == textureId && candidate.blend == blend) {
+                batch = &candidate;
+                break;
+            }
+        }
+        if (!batch) {
+            batches.push_back({textureId, blend, {}});
+            batch = &batches.back();
+        }
+        batch->submissions.push_back({&particles, color, rotate});
+    }
+    
+    // Draws and drops every submission; in headless mode only counts them
+    static void Flush() {
+        stats = ParticleRenderStats();
+        
+        for (Batch& batch : batches) {
+            if (batch.submissions.empty()) continue;
+            stats.batches++;
+            
+            if (!headless) {
+                BeginBlendMode(batch.blend == ParticleBlend::Additive ? BLEND_ADDITIVE : BLEND_ALPHA);
+            }
+            
+            for (const Submission& submission : batch.submissions) {
+                stats.emitters++;
+                stats.quads += (int)submission.particles->Count();
+                if (!headless) DrawQuads(batch.textureId, submission);
+            }
+            batch.submissions.clear();
+            
+            if (!headless) {
+                rlSetTexture(0);
+                EndBlendMode();
+            }
+        }
+        stats.vertices = stats.quads * 4;
+    }
+    
+    // Headless mode never touches the GPU: Submit and Flush only count
+    // quads and vertices, for benchmarks and servers without a window
+    static void SetHeadless(bool value) { headless = value; }
+    static bool IsHeadless() { return headless; }
+    
+    static const ParticleRenderStats& GetStats() { return stats; }
+    
+    // White disk fading out towards its rim, created on first use
+    static Texture2D GetSoftCircleTexture() {
+        if (softCircle.id == 0) {
+            Image image = GenImageGradientRadial(64, 64, 0.0f, WHITE, BLANK);
+            softCircle = LoadTextureFromImage(image);
+            UnloadImage(image);
+        }
+        return softCircle;
+    }
+    
+    // Releases the shared texture; call before closing the window
+    static void Shutdown() {
+        for (Batch& batch : batches) {
+            batch.submissions.clear();
+        }
+        if (softCircle.id != 0) {
+            UnloadTexture(softCircle);
+            softCircle = Texture2D();
+        }
+    }
+
+private:
+    struct Submission {
+        const ParticleBuffer* particles;
+        Color color;
+        bool rotate;
+    };
+    
+    // Kept across frames, so steady state submits without allocating
+    struct Batch {
+        unsigned int textureId;
+        ParticleBlend blend;
+        std::vector<Submission> submissions;
+    };
+    
+    static inline std::vector<Batch> batches;
+    static inline ParticleRenderStats stats;
+    static inline Texture2D softCircle = {};
+    static inline bool headless = false;
+    
+    // Quads are as wide as DrawCircleV's diameter was; alpha fades out
+    // over each particle's lifetime
+    static void DrawQuads(unsigned int textureId, const Submission& submission) {
+        const ParticleBuffer& p = *submission.particles;
+        Color color = submission.color;
+        size_t count = p.Count();
+        
+        for (size_t begin = 0; begin < count; begin += QuadsPerChunk) {
+            size_t end = std::min(count, begin + QuadsPerChunk);
+            
+            // Draws the pending batch first if these quads wouldn't fit
+            rlCheckRenderBatchLimit((int)(end - begin) * 4);
+            rlSetTexture(textureId);
+            rlBegin(RL_QUADS);
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            
+            for (size_t i = begin; i < end; i++) {
+                color.a = (unsigned char)((1.0f - p.GetLifeFraction(i)) * 255);
+                rlColor4ub(color.r, color.g, color.b, color.a);
+                
+                float x = p.posX[i];
+                float y = p.posY[i];
+                float h = p.size[i];
+                
+                // Half extents along the quad's axes
+                float ux = h, uy = 0.0f;
+                float vx = 0.0f, vy = h;
+                if (submission.rotate) {
+                    float c = std::cos(p.rotation[i] * DEG2RAD);
+                    float s = std::sin(p.rotation[i] * DEG2RAD);
+                    ux = c * h; uy = s * h;
+                    vx = -s * h; vy = c * h;
+                }
+                
+                // Top-left, bottom-left, bottom-right, top-right
+                rlTexCoord2f(0.0f, 0.0f); rlVertex2f(x - ux - vx, y - uy - vy);
+                rlTexCoord2f(0.0f, 1.0f); rlVertex2f(x - ux + vx, y - uy + vy);
+                rlTexCoord2f(1.0f, 1.0f); rlVertex2f(x + ux + vx, y + uy + vy);
+                rlTexCoord2f(1.0f, 0.0f); rlVertex2f(x + ux - vx, y + uy - vy);
+            }
+            
+            rlEnd();
+        }
+    }
+};
+
+}
@@ -4,42 +4,110 @@
 #include "Component.h"
 #include "GameObject.h"
 #include "Time.h"
+#include "Rng.h"
+#include "JobSystem.h"
+#include "ParticleBuffer.h"
+#include "ParticleRenderer.h"
+#include <atomic>
 
 namespace RayGame {
 
-struct Particle {
-    Vector2 position;
-    Vector2 velocity;
-    Vector2 acceleration;
-    Color color;
-    float lifetime;
-    float age;
-    float size;
-    float rotation;
-    float rotationSpeed;
-    bool active;
-    
-    void Update(float deltaTime) {
-        if (!active) return;
+// Global cap on live particles across every emitter, plus an emission
+// scale that drops while frames run slower than a target frame time.
+// Emitters ask it for room before emitting and hand particles back as they
+// die, so the count is exact and safe from any thread.
+class RAYGAME_API ParticleBudget {
+public:
+    // 0 means no limit
+    static void SetLimit(int maxParticles) { limit = std::max(0, maxParticles); }
+    static int GetLimit() { return limit; }
+    
+    // 0 turns frame-time pressure off
+    static void SetTargetFrameTime(float seconds) { targetFrameTime = std::max(0.0f, seconds); }
+    static float GetTargetFrameTime() { return targetFrameTime; }
+    
+    static int GetLiveCount() { return live.load(std::memory_order_relaxed); }
+    
+    // Fraction of requested particles emitters get right now, in (0, 1]
+    static float GetEmissionScale() { return emissionScale; }
+    
+    // Once per frame, from the main thread. Tracks a smoothed frame time;
+    // while it is above the target the scale shrinks in proportion, and it
+    // recovers as frames speed up again.
+    static void BeginFrame(float dt) {
+        smoothedFrameTime += (dt - smoothedFrameTime) * 0.1f;
         
-        age += deltaTime;
-        if (age >= lifetime) {
-            active = false;
-            return;
+        float target = 1.0f;
+        if (targetFrameTime > 0 && smoothedFrameTime > targetFrameTime) {
+            target = targetFrameTime / smoothedFrameTime;
+        }
+        emissionScale = std::max(MinEmissionScale, target);
+    }
+    
+    // Grants up to count particles within the limit; the grant is live until released
+    static int Acquire(int count) {
+        if (count <= 0) return 0;
+        if (limit == 0) {
+            live.fetch_add(count, std::memory_order_relaxed);
+            return count;
         }
         
-        velocity.x += acceleration.x * deltaTime;
-        velocity.y += acceleration.y * deltaTime;
-        
-        position.x += velocity.x * deltaTime;
-        position.y += velocity.y * deltaTime;
-        
-        rotation += rotationSpeed * deltaTime;
-        
-        // Fade out over lifetime
-        float t = age / lifetime;
-        color.a = (unsigned char)((1.0f - t) * 255);
+        int current = live.load(std::memory_order_relaxed);
+        int granted;
+        do {
+            granted = std::max(0, std::min(count, limit - current));
+            if (granted == 0) return 0;
+        } while (!live.compare_exchange_weak(current, current + granted, std::memory_order_relaxed));
+        return granted;
     }
+    
+    static void Release(int count) {
+        if (count > 0) live.fetch_sub(count, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr float MinEmissionScale = 0.1f;
+    
+    static inline std::atomic<int> live{0};
+    static inline int limit = 0;
+    static inline float targetFrameTime = 0;
+    static inline float smoothedFrameTime = 0;
+    static inline float emissionScale = 1.0f;
+};
+
+class ParticleEmitter;
+
+// Simulates every emitter scheduled this frame on the job system. Emitters
+// schedule themselves from Update; Scene runs the pass right after its
+// component updates. Each emitter emits from its own Rng stream and large
+// emitters are integrated in chunks, so results don't depend on the
+// thread count (unless the ParticleBudget limit is hit, which goes to
+// whichever emitter asks first).
+class RAYGAME_API ParticleSimulation {
+public:
+    // Particles integrated per job; bigger emitters are split
+    static constexpr size_t ChunkSize = 4096;
+    
+    // Emitters per job for emission and cleanup
+    static constexpr size_t EmitterBatch = 16;
+    
+    static void Schedule(ParticleEmitter* emitter);
+    static void Unschedule(ParticleEmitter* emitter);
+    
+    // Emits, integrates and culls every scheduled emitter, then clears the schedule
+    static void Run(float dt);
+    
+    static size_t GetScheduledCount() { return scheduled.size(); }
+
+private:
+    struct Span {
+        ParticleEmitter* emitter;
+        size_t begin;
+        size_t end;
+    };
+    
+    static inline std::vector<ParticleEmitter*> scheduled;  // Null where an emitter went away
+    static inline std::vector<Span> spans;
 };
 
 enum class EmitterShape {
@@ -81,8 +149,30 @@ public:
     float rotationSpeedMin = -180.0f;
     float rotationSpeedMax = 180.0f;
     
+    // Drawing; custom textures also turn with each particle's rotation
+    Texture2D texture = {};  // id 0 uses a shared soft circle
+    ParticleBlend blend = ParticleBlend::Alpha;
+    
+    // Each emitter draws from its own stream of the global seed, numbered
+    // in creation order. After Rng::SetGlobalSeed, emitters that already
+    // exist are reseeded from the new seed the next time they schedule or
+    // burst, taking the next stream number in that order, so a seeded
+    // replay also covers pooled emitters.
     ParticleEmitter() {
-        particles.reserve(maxParticles);
+        ReseedIfStale();
+        particles.Reserve(maxParticles);
+    }
+    
+    ~ParticleEmitter() {
+        ParticleSimulation::Unschedule(this);
+        ParticleBudget::Release((int)particles.Count());
+    }
+    
+    // Pins the emitter's random stream, e.g. for replays; SetGlobalSeed no
+    // longer reseeds it
+    void SetRandomSeed(uint64_t seed, uint64_t stream) {
+        rng.Seed(seed, stream);
+        seedPinned = true;
     }
     
     void Start() override {
@@ -90,6 +180,8 @@ public:
         durationTimer = 0;
     }
     
+    // Runs the emission timers and schedules the emitter; emitting and
+    // simulating happen in ParticleSimulation::Run, on the job system
     void Update() override {
         if (!gameObject) return;
         
@@ -103,105 +195,243 @@ public:
             }
         }
         
-        // Emit particles
+        // Count particles due this frame
         if (emitting) {
             emissionTimer += dt;
             float interval = 1.0f / emissionRate;
             
-            while (emissionTimer >= interval && particles.size() < maxParticles) {
-                EmitParticle();
+            while (emissionTimer >= interval && (int)particles.Count() + pendingEmit < maxParticles) {
                 emissionTimer -= interval;
+                pendingEmit++;
             }
         }
         
-        // Update particles
-        for (auto& p : particles) {
-            p.Update(dt);
+        // World pose is read here, on the main thread, for the workers
+        if (pendingEmit > 0) {
+            emitOrigin = gameObject->transform->GetWorldPosition();
+            emitRotation = gameObject->transform->GetWorldRotation();
         }
-        
-        // Remove dead particles
-        particles.erase(
-            std::remove_if(particles.begin(), particles.end(),
-                [](const Particle& p) { return !p.active; }),
-            particles.end()
-        );
+        ReseedIfStale();
+        ParticleSimulation::Schedule(this);
     }
     
+    // Queued with ParticleRenderer, which draws all emitters sharing a
+    // texture and blend mode together. Color fades from startColor to
+    // transparent over each lifetime.
     void Render() override {
-        for (const auto& p : particles) {
-            if (p.active) {
-                DrawCircleV(p.position, p.size, p.color);
-            }
-        }
+        ParticleRenderer::Submit(particles, startColor, texture, blend, texture.id != 0);
     }
     
     void EmitParticle() {
-        if (particles.size() >= maxParticles) return;
-        
-        Particle p;
-        p.position = GetEmissionPosition();
-        p.velocity = Random(startVelocityMin, startVelocityMax);
-        p.acceleration = acceleration;
-        p.lifetime = Random(lifetimeMin, lifetimeMax);
-        p.age = 0;
-        p.size = Random(startSizeMin, startSizeMax);
-        p.rotation = Random(0.0f, 360.0f);
-        p.rotationSpeed = Random(rotationSpeedMin, rotationSpeedMax);
-        p.color = startColor;
-        p.active = true;
-        
-        particles.push_back(p);
+        Burst(1);
     }
     
+    // Emits right away, from the emitter's current world pose
     void Burst(int count) {
-        for (int i = 0; i < count && particles.size() < maxParticles; i++) {
-            EmitParticle();
-        }
+        ReseedIfStale();
+        Transform* tf = gameObject->transform.get();
+        Emit(count, tf->GetWorldPosition(), tf->GetWorldRotation());
     }
     
     void Clear() {
-        particles.clear();
+        ParticleBudget::Release((int)particles.Count());
+        particles.Clear();
+    }
+    
+    // Drops live particles and starts emitting from scratch
+    void Restart() {
+        Clear();
+        emissionTimer = 0;
+        durationTimer = 0;
+        emissionCarry = 0;
+        pendingEmit = 0;
+        emitting = true;
+    }
+    
+    // Emitting, or still showing particles
+    bool IsAlive() const {
+        return emitting || particles.Count() > 0;
     }
     
     int GetParticleCount() const {
-        return particles.size();
+        return (int)particles.Count();
     }
     
+    const ParticleBuffer& GetParticles() const { return particles; }
+
 private:
-    std::vector<Particle> particles;
+    friend class ParticleSimulation;
+    
+    ParticleBuffer particles;
     float emissionTimer = 0;
     float durationTimer = 0;
     
-    Vector2 GetEmissionPosition() {
-        Vector2 pos = gameObject->transform->position;
+    Rng rng;
+    int pendingEmit = 0;         // Due in this frame's simulation pass
+    Vector2 emitOrigin = {0, 0};
+    float emitRotation = 0;
+    int scheduleSlot = -1;       // Index in ParticleSimulation's schedule
+    
+    uint64_t seedEpoch = 0;      // Rng::GetGlobalEpoch() when rng was last seeded
+    bool seedPinned = false;     // Set by SetRandomSeed
+    
+    // Runs on the main thread only (construction, Update, Burst), so the
+    // order streams are handed out in is the game's own order
+    void ReseedIfStale() {
+        uint64_t epoch = Rng::GetGlobalEpoch();
+        if (seedPinned || seedEpoch == epoch) return;
+        
+        seedEpoch = epoch;
+        rng.Seed(Rng::GetGlobalSeed(), NextStream(epoch));
+    }
+    
+    // Restarts numbering with every global seed. Stays above the streams
+    // Rng::ThreadLocal hands to job system threads.
+    static uint64_t NextStream(uint64_t epoch) {
+        static uint64_t next = 0;
+        static uint64_t nextEpoch = 0;
+        if (nextEpoch != epoch) {
+            nextEpoch = epoch;
+            next = 1ull << 32;
+        }
+        return next++;
+    }
+    
+    std::vector<float> scratch;  // Random lanes for Emit, kept between calls
+    
+    float emissionCarry = 0;     // Fraction of a particle owed by the emission scale
+    
+    // Emits up to count particles around origin, within maxParticles and
+    // the global ParticleBudget. Each random property is drawn for the
+    // whole batch with one Rng::Fill. Touches nothing outside the emitter
+    // and the budget, so emitters may emit on different threads.
+    void Emit(int count, Vector2 origin, float baseRotation) {
+        int room = maxParticles - (int)particles.Count();
+        count = std::max(0, std::min(count, room));
+        
+        // Scaled down under frame-time pressure; the remainder carries over
+        // so small emission rates still emit now and then
+        emissionCarry += count * ParticleBudget::GetEmissionScale();
+        count = std::min(count, (int)emissionCarry);
+        emissionCarry -= count;
+        
+        size_t n = (size_t)ParticleBudget::Acquire(count);
+        if (n == 0) return;
+        
+        enum { VelX, VelY, Lifetime, Size, Rotation, RotationSpeed, ShapeA, ShapeB, LaneCount };
+        scratch.resize(n * LaneCount);
+        auto lane = [&](int index) { return scratch.data() + index * n; };
+        
+        rng.Fill(lane(VelX), n, startVelocityMin.x, startVelocityMax.x);
+        rng.Fill(lane(VelY), n, startVelocityMin.y, startVelocityMax.y);
+        rng.Fill(lane(Lifetime), n, lifetimeMin, lifetimeMax);
+        rng.Fill(lane(Size), n, startSizeMin, startSizeMax);
+        rng.Fill(lane(Rotation), n, 0.0f, 360.0f);
+        rng.Fill(lane(RotationSpeed), n, rotationSpeedMin, rotationSpeedMax);
         
+        // Shape offsets: angle (degrees) and distance, or x and y for Box
         switch (shape) {
             case EmitterShape::Point:
-                return pos;
-                
-            case EmitterShape::Circle: {
-                float angle = Random(0, 360) * DEG2RAD;
-                float r = Random(0, radius);
-                return {pos.x + cos(angle) * r, pos.y + sin(angle) * r};
-            }
+                break;
+            
+            case EmitterShape::Circle:
+                rng.Fill(lane(ShapeA), n, 0.0f, 360.0f);
+                rng.Fill(lane(ShapeB), n, 0.0f, radius);
+                break;
             
             case EmitterShape::Box:
-                return {
-                    pos.x + Random(-boxSize.x/2, boxSize.x/2),
-                    pos.y + Random(-boxSize.y/2, boxSize.y/2)
-                };
-                
-            case EmitterShape::Cone: {
-                float baseAngle = gameObject->transform->rotation;
-                float angle = (baseAngle + Random(-coneAngle/2, coneAngle/2)) * DEG2RAD;
-                float r = Random(0, radius);
-                return {pos.x + cos(angle) * r, pos.y + sin(angle) * r};
-            }
+                rng.Fill(lane(ShapeA), n, -boxSize.x/2, boxSize.x/2);
+                rng.Fill(lane(ShapeB), n, -boxSize.y/2, boxSize.y/2);
+                break;
+            
+            case EmitterShape::Cone:
+                rng.Fill(lane(ShapeA), n, baseRotation - coneAngle/2, baseRotation + coneAngle/2);
+                rng.Fill(lane(ShapeB), n, 0.0f, radius);
+                break;
         }
         
-        return pos;
+        for (size_t i = 0; i < n; i++) {
+            Vector2 position = origin;
+            if (shape == EmitterShape::Box) {
+                position.x += lane(ShapeA)[i];
+                position.y += lane(ShapeB)[i];
+            } else if (shape != EmitterShape::Point) {
+                float angle = lane(ShapeA)[i] * DEG2RAD;
+                float r = lane(ShapeB)[i];
+                position.x += std::cos(angle) * r;
+                position.y += std::sin(angle) * r;
+            }
+            
+            particles.Add(position, {lane(VelX)[i], lane(VelY)[i]}, lane(Lifetime)[i],
+                          lane(Size)[i], lane(Rotation)[i], lane(RotationSpeed)[i]);
+        }
     }
 };
 
+
+inline void ParticleSimulation::Schedule(ParticleEmitter* emitter) {
+    if (emitter->scheduleSlot >= 0) return;
+    emitter->scheduleSlot = (int)scheduled.size();
+    scheduled.push_back(emitter);
+}
+
+inline void ParticleSimulation::Unschedule(ParticleEmitter* emitter) {
+    if (emitter->scheduleSlot < 0) return;
+    scheduled[emitter->scheduleSlot] = nullptr;
+    emitter->scheduleSlot = -1;
+}
+
+inline void ParticleSimulation::Run(float dt) {
+    if (scheduled.empty()) return;
+    
+    // Emit what each emitter's Update counted
+    JobSystem::ParallelFor(scheduled.size(), EmitterBatch, [](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            ParticleEmitter* emitter = scheduled[i];
+            if (!emitter || emitter->pendingEmit == 0) continue;
+            emitter->Emit(emitter->pendingEmit, emitter->emitOrigin, emitter->emitRotation);
+            emitter->pendingEmit = 0;
+        }
+    });
+    
+    // Integrate in spans of at most ChunkSize particles. Small emitters
+    // share a job; big ones are split over several.
+    spans.clear();
+    size_t total = 0;
+    for (ParticleEmitter* emitter : scheduled) {
+        if (!emitter) continue;
+        size_t count = emitter->particles.Count();
+        for (size_t begin = 0; begin < count; begin += ChunkSize) {
+            spans.push_back({emitter, begin, std::min(count, begin + ChunkSize)});
+        }
+        total += count;
+    }
+    
+    if (!spans.empty()) {
+        size_t spansPerJob = std::max<size_t>(1, ChunkSize * spans.size() / std::max<size_t>(1, total));
+        JobSystem::ParallelFor(spans.size(), spansPerJob, [dt](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+                const Span& span = spans[i];
+                ParticleEmitter* emitter = span.emitter;
+                emitter->particles.Integrate(span.begin, span.end, dt, emitter->acceleration);
+            }
+        });
+    }
+    
+    // Swap out the dead, emitter by emitter
+    JobSystem::ParallelFor(scheduled.size(), EmitterBatch, [](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            ParticleEmitter* emitter = scheduled[i];
+            if (!emitter) continue;
+            ParticleBudget::Release((int)emitter->particles.RemoveExpired());
+        }
+    });
+    
+    for (ParticleEmitter* emitter : scheduled) {
+        if (emitter) emitter->scheduleSlot = -1;
+    }
+    scheduled.clear();
+}
+
 }
 
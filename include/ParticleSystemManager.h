@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Core.h"
+#include "GameObject.h"
+#include "ParticleSystem.h"
+#include "StringId.h"
+
+namespace RayGame {
+
+// Plays one-shot particle effects from named presets. Effect objects live
+// outside the scene's object list and are pooled per preset: once an
+// effect has stopped emitting and its last particle died, it goes back to
+// its preset's pool for the next Play. Long sessions therefore settle on a
+// fixed number of effect objects, however many effects they play.
+// Each Scene owns one; its effects simulate alongside the scene's emitters
+// and render before the particle batch is flushed.
+class RAYGAME_API ParticleSystemManager {
+public:
+    using Configure = std::function<void(ParticleEmitter&)>;
+    
+    ParticleSystemManager() = default;
+    ParticleSystemManager(const ParticleSystemManager&) = delete;
+    ParticleSystemManager& operator=(const ParticleSystemManager&) = delete;
+    
+    // configure runs on every Play, after the emitter was restarted; burst
+    // particles are emitted right after. Registering a name again replaces
+    // its settings and keeps its pool.
+    void RegisterPreset(StringId name, Configure configure, int burst = 0) {
+        for (Preset& preset : presets) {
+            if (preset.name == name) {
+                preset.configure = std::move(configure);
+                preset.burst = burst;
+                return;
+            }
+        }
+        presets.push_back({name, std::move(configure), burst, {}});
+    }
+    
+    // Null for unknown presets. The emitter may be tweaked right away, but
+    // don't keep the pointer: it is recycled once the effect has finished.
+    // Looping presets play until their emitter's emitting flag is cleared.
+    ParticleEmitter* Play(StringId presetName, Vector2 position, float rotation = 0.0f) {
+        uint32_t index = FindPreset(presetName);
+        if (index == InvalidPreset) return nullptr;
+        
+        Preset& preset = presets[index];
+        Instance instance;
+        if (!preset.pool.empty()) {
+            instance = std::move(preset.pool.back());
+            preset.pool.pop_back();
+        } else {
+            instance.object = CreateRef<GameObject>("ParticleEffect");
+            instance.emitter = instance.object->AddComponent<ParticleEmitter>().get();
+            instance.object->Start();
+        }
+        instance.preset = index;
+        
+        Transform* tf = instance.object->transform.get();
+        tf->position = position;
+        tf->rotation = rotation;
+        
+        ParticleEmitter* emitter = instance.emitter;
+        emitter->Restart();
+        if (preset.configure) preset.configure(*emitter);
+        if (preset.burst > 0) emitter->Burst(preset.burst);
+        
+        active.push_back(std::move(instance));
+        return emitter;
+    }
+    
+    // Schedules every playing effect for this frame's ParticleSimulation
+    // pass and feeds the frame time to ParticleBudget
+    void Update() {
+        ParticleBudget::BeginFrame(GameTime::DeltaTime());
+        
+        for (Instance& instance : active) {
+            instance.emitter->Update();
+        }
+    }
+    
+    // Returns effects that stopped emitting and have no particles left to
+    // their pools; call after the simulation pass
+    void RecycleFinished() {
+        // Swap-with-last; walking backwards, the swapped-in effect was already checked
+        for (size_t i = active.size(); i-- > 0;) {
+            if (!active[i].emitter->IsAlive()) Recycle(i);
+        }
+    }
+    
+    void Render() {
+        for (Instance& instance : active) {
+            instance.emitter->Render();
+        }
+    }
+    
+    // Stops every effect at once and returns it to its pool
+    void Clear() {
+        while (!active.empty()) {
+            active.back().emitter->Clear();
+            active.back().emitter->emitting = false;
+            Recycle(active.size() - 1);
+        }
+    }
+    
+    size_t GetActiveCount() const { return active.size(); }
+    
+    size_t GetPooledCount() const {
+        size_t count = 0;
+        for (const Preset& preset : presets) {
+            count += preset.pool.size();
+        }
+        return count;
+    }
+
+private:
+    static constexpr uint32_t InvalidPreset = 0xFFFFFFFFu;
+    
+    struct Instance {
+        Ref<GameObject> object;
+        ParticleEmitter* emitter = nullptr;
+        uint32_t preset = InvalidPreset;
+    };
+    
+    struct Preset {
+        StringId name;
+        Configure configure;
+        int burst;
+        std::vector<Instance> pool;  // Finished effects, ready to replay
+    };
+    
+    std::vector<Preset> presets;
+    std::vector<Instance> active;
+    
+    uint32_t FindPreset(StringId name) const {
+        for (size_t i = 0; i < presets.size(); i++) {
+            if (presets[i].name == name) return (uint32_t)i;
+        }
+        return InvalidPreset;
+    }
+    
+    void Recycle(size_t index) {
+        Instance instance = std::move(active[index]);
+        if (index != active.size() - 1) active[index] = std::move(active.back());
+        active.pop_back();
+        presets[instance.preset].pool.push_back(std::move(instance));
+    }
+};
+
+}
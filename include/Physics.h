@@ -4,6 +4,9 @@
 #include "Component.h"
 #include "GameObject.h"
 #include "Time.h"
+#include "SpatialHash.h"
+#include "AABBTree.h"
+#include "BodyStorage.h"
 
 namespace RayGame {
 
@@ -12,25 +15,80 @@ enum class ColliderType {
     Circle
 };
 
+// Number of collision layers a collider can be placed on
+constexpr int MaxCollisionLayers = 32;
+
+// Layers outside [0, MaxCollisionLayers) have no bit, so a collider placed
+// on one touches nothing and masking one in or out changes nothing
+inline uint32_t LayerBit(int layer) {
+    if (layer < 0 || layer >= MaxCollisionLayers) return 0;
+    return 1u << layer;
+}
+
+class Rigidbody;
+
 class RAYGAME_API Collider : public Component {
 public:
     ColliderType type;
     Vector2 offset = {0, 0};
     bool isTrigger = false;
     
-    virtual bool CheckCollision(Collider* other) = 0;
+    // Layer this collider lives on and the layers it may touch.
+    // A pair is only tested when each side's mask contains the other's layer.
+    int layer = 0;
+    uint32_t collisionMask = 0xFFFFFFFFu;
+    
+    // Registers with PhysicsWorld for the lifetime of the component. Also
+    // started while disabled, so enabling it later is enough to collide.
+    void Start() override;
+    void OnDestroy() override;
+    
+    void SetCollidesWith(int otherLayer, bool value) {
+        if (value) {
+            collisionMask |= LayerBit(otherLayer);
+        } else {
+            collisionMask &= ~LayerBit(otherLayer);
+        }
+    }
+    
+    // Rigidbody on the same object; kept current as bodies start and are removed
+    Rigidbody* GetAttachedRigidbody() const { return attachedRigidbody; }
+    
+    bool CanCollideWith(const Collider* other) const {
+        return (collisionMask & LayerBit(other->layer)) != 0 &&
+               (other->collisionMask & LayerBit(layer)) != 0;
+    }
+    
+    // True if the two shapes overlap (any pair of shapes)
+    virtual bool CheckCollision(Collider* other);
+    virtual Rectangle GetBounds() const = 0;
     virtual void DebugDraw() = 0;
     
+    // Shape queries used by PhysicsWorld::QueryRect/QueryRadius/Raycast
+    virtual bool OverlapsRect(const Rectangle& rect) const = 0;
+    virtual bool OverlapsCircle(Vector2 center, float r) const = 0;
+    virtual bool Raycast(Vector2 origin, Vector2 direction, float maxDistance,
+                         float& distance, Vector2& normal) const = 0;
+    
     Vector2 GetWorldPosition() const {
         if (!gameObject) return {0, 0};
-        return {
-            gameObject->transform->position.x + offset.x,
-            gameObject->transform->position.y + offset.y
-        };
+        Vector2 position = gameObject->transform->GetWorldPosition();
+        return {position.x + offset.x, position.y + offset.y};
     }
     
 protected:
-    Collider(ColliderType t) : type(t) {}
+    friend class PhysicsWorld;
+    int proxyId = DynamicAABBTree::Null;  // Leaf in the world's AABB tree
+    int worldIndex = -1;                  // Slot in PhysicsWorld's collider list
+    uint32_t colliderId = 0;              // Stable id used to key contact pairs
+    int contactCount = 0;                 // Cached pairs this collider is part of
+    Rectangle lastBounds = {0, 0, -1, -1};  // Bounds at the previous step
+    bool idle = false;                    // Unmoved and without an awake body this step
+    Rigidbody* attachedRigidbody = nullptr;
+    
+    Collider(ColliderType t) : type(t) {
+        startWhenDisabled = true;
+    }
 };
 
 class RAYGAME_API BoxCollider : public Collider {
@@ -40,7 +98,7 @@ public:
     BoxCollider() : Collider(ColliderType::Box) {}
     BoxCollider(Vector2 sz) : Collider(ColliderType::Box), size(sz) {}
     
-    Rectangle GetBounds() const {
+    Rectangle GetBounds() const override {
         Vector2 pos = GetWorldPosition();
         return {
             pos.x - size.x / 2,
@@ -50,12 +108,52 @@ public:
         };
     }
     
-    bool CheckCollision(Collider* other) override {
-        if (other->type == ColliderType::Box) {
-            auto* otherBox = static_cast<BoxCollider*>(other);
-            return CheckCollisionRecs(GetBounds(), otherBox->GetBounds());
+    bool OverlapsRect(const Rectangle& rect) const override {
+        return CheckCollisionRecs(GetBounds(), rect);
+    }
+    
+    bool OverlapsCircle(Vector2 center, float r) const override {
+        return CheckCollisionCircleRec(center, r, GetBounds());
+    }
+    
+    bool Raycast(Vector2 origin, Vector2 direction, float maxDistance,
+                 float& distance, Vector2& normal) const override {
+        Rectangle b = GetBounds();
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        Vector2 hitNormal = {-direction.x, -direction.y};  // Ray starts inside
+        
+        const float origins[2] = {origin.x, origin.y};
+        const float dirs[2] = {direction.x, direction.y};
+        const float lo[2] = {b.x, b.y};
+        const float hi[2] = {b.x + b.width, b.y + b.height};
+        
+        for (int axis = 0; axis < 2; axis++) {
+            if (std::fabs(dirs[axis]) < 1e-8f) {
+                if (origins[axis] < lo[axis] || origins[axis] > hi[axis]) return false;
+                continue;
+            }
+            
+            float inv = 1.0f / dirs[axis];
+            float t1 = (lo[axis] - origins[axis]) * inv;
+            float t2 = (hi[axis] - origins[axis]) * inv;
+            float side = -1.0f;
+            if (t1 > t2) {
+                std::swap(t1, t2);
+                side = 1.0f;
+            }
+            
+            if (t1 > tMin) {
+                tMin = t1;
+                hitNormal = axis == 0 ? Vector2{side, 0} : Vector2{0, side};
+            }
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) return false;
         }
-        return false;
+        
+        distance = tMin;
+        normal = hitNormal;
+        return true;
     }
     
     void DebugDraw() override {
@@ -71,15 +169,43 @@ public:
     CircleCollider() : Collider(ColliderType::Circle) {}
     CircleCollider(float r) : Collider(ColliderType::Circle), radius(r) {}
     
-    bool CheckCollision(Collider* other) override {
-        if (other->type == ColliderType::Circle) {
-            auto* otherCircle = static_cast<CircleCollider*>(other);
-            return CheckCollisionCircles(
-                GetWorldPosition(), radius,
-                otherCircle->GetWorldPosition(), otherCircle->radius
-            );
+    Rectangle GetBounds() const override {
+        Vector2 pos = GetWorldPosition();
+        return {pos.x - radius, pos.y - radius, radius * 2, radius * 2};
+    }
+    
+    bool OverlapsRect(const Rectangle& rect) const override {
+        return CheckCollisionCircleRec(GetWorldPosition(), radius, rect);
+    }
+    
+    bool OverlapsCircle(Vector2 center, float r) const override {
+        return CheckCollisionCircles(GetWorldPosition(), radius, center, r);
+    }
+    
+    bool Raycast(Vector2 origin, Vector2 direction, float maxDistance,
+                 float& distance, Vector2& normal) const override {
+        Vector2 center = GetWorldPosition();
+        Vector2 m = {origin.x - center.x, origin.y - center.y};
+        float c = m.x * m.x + m.y * m.y - radius * radius;
+        
+        if (c <= 0) {  // Ray starts inside
+            distance = 0;
+            normal = {-direction.x, -direction.y};
+            return true;
         }
-        return false;
+        
+        float b = m.x * direction.x + m.y * direction.y;
+        if (b > 0) return false;  // Pointing away
+        
+        float disc = b * b - c;
+        if (disc < 0) return false;
+        
+        float t = -b - std::sqrt(disc);
+        if (t > maxDistance) return false;
+        
+        distance = t;
+        normal = Normalize({m.x + direction.x * t, m.y + direction.y * t});
+        return true;
     }
     
     void DebugDraw() override {
@@ -88,92 +214,641 @@ public:
     }
 };
 
-class RAYGAME_API Rigidbody : public Component {
+// Result of a narrowphase test
+struct ContactManifold {
+    Vector2 normal = {0, 0};  // Points from the first collider towards the second
+    float depth = 0.0f;       // Penetration along the normal
+    Vector2 points[2] = {};
+    int pointCount = 0;
+};
+
+// Shape-vs-shape tests producing contact manifolds
+class RAYGAME_API Narrowphase {
 public:
-    Vector2 velocity = {0, 0};
-    Vector2 acceleration = {0, 0};
-    float mass = 1.0f;
-    float drag = 0.99f;  // Air resistance
-    float gravity = 0.0f;
-    bool useGravity = false;
-    bool isKinematic = false;  // If true, not affected by forces
-    
-    Rigidbody() = default;
+    static bool Collide(const Collider* a, const Collider* b, ContactManifold& m) {
+        if (a->type == ColliderType::Box) {
+            if (b->type == ColliderType::Box) {
+                return BoxBox(static_cast<const BoxCollider*>(a), static_cast<const BoxCollider*>(b), m);
+            }
+            return BoxCircle(static_cast<const BoxCollider*>(a), static_cast<const CircleCollider*>(b), m);
+        }
+        
+        if (b->type == ColliderType::Box) {
+            if (!BoxCircle(static_cast<const BoxCollider*>(b), static_cast<const CircleCollider*>(a), m)) {
+                return false;
+            }
+            m.normal = {-m.normal.x, -m.normal.y};
+            return true;
+        }
+        return CircleCircle(static_cast<const CircleCollider*>(a), static_cast<const CircleCollider*>(b), m);
+    }
     
-    void AddForce(Vector2 force) {
-        if (isKinematic) return;
-        acceleration.x += force.x / mass;
-        acceleration.y += force.y / mass;
+    static bool CircleCircle(const CircleCollider* a, const CircleCollider* b, ContactManifold& m) {
+        Vector2 pa = a->GetWorldPosition();
+        Vector2 pb = b->GetWorldPosition();
+        Vector2 d = {pb.x - pa.x, pb.y - pa.y};
+        float distSq = d.x * d.x + d.y * d.y;
+        float radii = a->radius + b->radius;
+        if (distSq > radii * radii) return false;
+        
+        float dist = std::sqrt(distSq);
+        m.normal = dist > 1e-6f ? Vector2{d.x / dist, d.y / dist} : Vector2{0, 1};
+        m.depth = radii - dist;
+        m.points[0] = {pa.x + m.normal.x * a->radius, pa.y + m.normal.y * a->radius};
+        m.pointCount = 1;
+        return true;
     }
     
-    void AddImpulse(Vector2 impulse) {
-        if (isKinematic) return;
-        velocity.x += impulse.x / mass;
-        velocity.y += impulse.y / mass;
+    // Separating axis test; boxes are axis-aligned so only two axes exist
+    static bool BoxBox(const BoxCollider* a, const BoxCollider* b, ContactManifold& m) {
+        Rectangle ra = a->GetBounds();
+        Rectangle rb = b->GetBounds();
+        
+        float overlapX = std::min(ra.x + ra.width, rb.x + rb.width) - std::max(ra.x, rb.x);
+        float overlapY = std::min(ra.y + ra.height, rb.y + rb.height) - std::max(ra.y, rb.y);
+        if (overlapX <= 0 || overlapY <= 0) return false;
+        
+        float dx = (rb.x + rb.width / 2) - (ra.x + ra.width / 2);
+        float dy = (rb.y + rb.height / 2) - (ra.y + ra.height / 2);
+        
+        // Contact points are the ends of the overlapping stretch of the touching faces
+        if (overlapX < overlapY) {
+            float sign = dx < 0 ? -1.0f : 1.0f;
+            float x = sign > 0 ? ra.x + ra.width - overlapX / 2 : ra.x + overlapX / 2;
+            float y0 = std::max(ra.y, rb.y);
+            float y1 = std::min(ra.y + ra.height, rb.y + rb.height);
+            m.normal = {sign, 0};
+            m.depth = overlapX;
+            m.points[0] = {x, y0};
+            m.points[1] = {x, y1};
+        } else {
+            float sign = dy < 0 ? -1.0f : 1.0f;
+            float y = sign > 0 ? ra.y + ra.height - overlapY / 2 : ra.y + overlapY / 2;
+            float x0 = std::max(ra.x, rb.x);
+            float x1 = std::min(ra.x + ra.width, rb.x + rb.width);
+            m.normal = {0, sign};
+            m.depth = overlapY;
+            m.points[0] = {x0, y};
+            m.points[1] = {x1, y};
+        }
+        m.pointCount = 2;
+        return true;
     }
     
-    void Update() override {
-        if (isKinematic || !gameObject) return;
+    static bool BoxCircle(const BoxCollider* a, const CircleCollider* b, ContactManifold& m) {
+        Rectangle r = a->GetBounds();
+        Vector2 c = b->GetWorldPosition();
+        
+        Vector2 closest = {
+            Clamp(c.x, r.x, r.x + r.width),
+            Clamp(c.y, r.y, r.y + r.height)
+        };
+        Vector2 d = {c.x - closest.x, c.y - closest.y};
+        float distSq = d.x * d.x + d.y * d.y;
+        
+        if (distSq > 1e-12f) {
+            if (distSq > b->radius * b->radius) return false;
+            
+            float dist = std::sqrt(distSq);
+            m.normal = {d.x / dist, d.y / dist};
+            m.depth = b->radius - dist;
+            m.points[0] = closest;
+            m.pointCount = 1;
+            return true;
+        }
+        
+        // Center inside the box: push out through the nearest face
+        float left = c.x - r.x;
+        float right = r.x + r.width - c.x;
+        float top = c.y - r.y;
+        float bottom = r.y + r.height - c.y;
+        float nearest = std::min(std::min(left, right), std::min(top, bottom));
         
-        float dt = GameTime::DeltaTime();
+        if (nearest == left) {
+            m.normal = {-1, 0};
+            m.points[0] = {r.x, c.y};
+        } else if (nearest == right) {
+            m.normal = {1, 0};
+            m.points[0] = {r.x + r.width, c.y};
+        } else if (nearest == top) {
+            m.normal = {0, -1};
+            m.points[0] = {c.x, r.y};
+        } else {
+            m.normal = {0, 1};
+            m.points[0] = {c.x, r.y + r.height};
+        }
+        m.depth = b->radius + nearest;
+        m.pointCount = 1;
+        return true;
+    }
+    
+    // Time of impact of collider a moving by delta against b held still.
+    // Fails if the shapes don't meet during the move or already overlap.
+    // The normal points from a towards b at the moment of impact.
+    static bool Sweep(const Collider* a, Vector2 delta, const Collider* b, float& toi, Vector2& normal) {
+        Vector2 origin = a->GetWorldPosition();
         
-        // Apply gravity
-        if (useGravity) {
-            acceleration.y += gravity;
+        if (a->type == ColliderType::Circle && b->type == ColliderType::Circle) {
+            float radius = static_cast<const CircleCollider*>(a)->radius +
+                           static_cast<const CircleCollider*>(b)->radius;
+            return SweepPoint(origin, delta, b->GetWorldPosition(), radius, toi, normal);
         }
         
-        // Update velocity
-        velocity.x += acceleration.x * dt;
-        velocity.y += acceleration.y * dt;
+        // Every other pair is cast against b's bounds grown by a's half extents.
+        // Exact for two boxes; rounded corners are treated as square otherwise.
+        Rectangle ab = a->GetBounds();
+        Rectangle bb = b->GetBounds();
+        Rectangle target = {
+            bb.x - ab.width / 2, bb.y - ab.height / 2,
+            bb.width + ab.width, bb.height + ab.height
+        };
+        return SweepPoint(origin, delta, target, toi, normal);
+    }
+    
+private:
+    static bool SweepPoint(Vector2 origin, Vector2 delta, Vector2 center, float radius,
+                           float& toi, Vector2& normal) {
+        Vector2 m = {origin.x - center.x, origin.y - center.y};
+        float c = m.x * m.x + m.y * m.y - radius * radius;
+        if (c <= 0) return false;  // Already overlapping
         
-        // Apply drag
-        velocity.x *= drag;
-        velocity.y *= drag;
+        float b = m.x * delta.x + m.y * delta.y;
+        if (b >= 0) return false;  // Moving away
         
-        // Update position
-        gameObject->transform->position.x += velocity.x * dt;
-        gameObject->transform->position.y += velocity.y * dt;
+        float a = delta.x * delta.x + delta.y * delta.y;
+        float disc = b * b - a * c;
+        if (disc < 0) return false;
         
-        // Reset acceleration
-        acceleration = {0, 0};
+        float t = (-b - std::sqrt(disc)) / a;
+        if (t > 1.0f) return false;
+        
+        toi = t;
+        normal = {-(m.x + delta.x * t) / radius, -(m.y + delta.y * t) / radius};
+        return true;
+    }
+    
+    static bool SweepPoint(Vector2 origin, Vector2 delta, const Rectangle& r,
+                           float& toi, Vector2& normal) {
+        float tMin = -1.0f;  // Stays negative if the point starts inside
+        float tMax = 1.0f;
+        Vector2 hitNormal = {0, 0};
+        
+        const float origins[2] = {origin.x, origin.y};
+        const float deltas[2] = {delta.x, delta.y};
+        const float lo[2] = {r.x, r.y};
+        const float hi[2] = {r.x + r.width, r.y + r.height};
+        
+        for (int axis = 0; axis < 2; axis++) {
+            if (std::fabs(deltas[axis]) < 1e-8f) {
+                if (origins[axis] <= lo[axis] || origins[axis] >= hi[axis]) return false;
+                continue;
+            }
+            
+            float inv = 1.0f / deltas[axis];
+            float t1 = (lo[axis] - origins[axis]) * inv;
+            float t2 = (hi[axis] - origins[axis]) * inv;
+            float side = 1.0f;  // Entering through the low face pushes towards +axis
+            if (t1 > t2) {
+                std::swap(t1, t2);
+                side = -1.0f;
+            }
+            
+            if (t1 > tMin) {
+                tMin = t1;
+                hitNormal = axis == 0 ? Vector2{side, 0} : Vector2{0, side};
+            }
+            tMax = std::min(tMax, t2);
+            if (tMin > tMax) return false;
+        }
+        
+        if (tMin < 0.0f) return false;  // Already overlapping
+        
+        toi = tMin;
+        normal = hitNormal;
+        return true;
+    }
+};
+
+// Thin handle into BodyStorage; PhysicsWorld::Step integrates all bodies at once
+class RAYGAME_API Rigidbody : public Component {
+public:
+    Rigidbody() {
+        body = BodyStorage::Create(this, &body);
+        startWhenDisabled = true;  // Colliders see the body even while it's off
+    }
+    
+    ~Rigidbody() override {
+        BodyStorage::Destroy(body);
+    }
+    
+    Rigidbody(const Rigidbody&) = delete;
+    Rigidbody& operator=(const Rigidbody&) = delete;
+    
+    // Attaches to the colliders on this object, and detaches again so they
+    // never keep a pointer to a removed body
+    void Start() override;
+    void OnDestroy() override;
+    
+    void AddForce(Vector2 force) {
+        if (IsKinematic()) return;
+        WakeUp();
+        BodyStorage::accX[body] += force.x * BodyStorage::invMass[body];
+        BodyStorage::accY[body] += force.y * BodyStorage::invMass[body];
+    }
+    
+    void AddImpulse(Vector2 impulse) {
+        if (IsKinematic()) return;
+        WakeUp();
+        BodyStorage::velX[body] += impulse.x * BodyStorage::invMass[body];
+        BodyStorage::velY[body] += impulse.y * BodyStorage::invMass[body];
     }
     
     void SetVelocity(Vector2 vel) {
-        velocity = vel;
+        if (vel.x != BodyStorage::velX[body] || vel.y != BodyStorage::velY[body]) {
+            WakeUp();
+        }
+        BodyStorage::velX[body] = vel.x;
+        BodyStorage::velY[body] = vel.y;
     }
     
     Vector2 GetVelocity() const {
-        return velocity;
+        return {BodyStorage::velX[body], BodyStorage::velY[body]};
     }
     
     float GetSpeed() const {
-        return sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+        Vector2 v = GetVelocity();
+        return sqrt(v.x * v.x + v.y * v.y);
+    }
+    
+    void SetMass(float value) {
+        BodyStorage::mass[body] = value;
+        BodyStorage::invMass[body] = value > 0 ? 1.0f / value : 0.0f;
+    }
+    
+    float GetMass() const { return BodyStorage::mass[body]; }
+    float GetInverseMass() const { return BodyStorage::invMass[body]; }
+    
+    // Fraction of velocity kept per step (air resistance)
+    void SetDrag(float value) { BodyStorage::drag[body] = value; }
+    float GetDrag() const { return BodyStorage::drag[body]; }
+    
+    void SetGravity(float value) {
+        BodyStorage::gravity[body] = value;
+        UpdateGravity();
+    }
+    
+    float GetGravity() const { return BodyStorage::gravity[body]; }
+    
+    void SetUseGravity(bool value) {
+        BodyStorage::useGravity[body] = value;
+        UpdateGravity();
+    }
+    
+    bool GetUseGravity() const { return BodyStorage::useGravity[body] != 0; }
+    
+    // Kinematic bodies are not affected by forces or integration
+    void SetKinematic(bool value) {
+        BodyStorage::kinematic[body] = value;
+        WakeUp();
+    }
+    
+    bool IsKinematic() const { return BodyStorage::kinematic[body] != 0; }
+    
+    // Continuous bodies are swept against other colliders each step, so they
+    // can't pass through shapes smaller than the distance they travel
+    void SetContinuous(bool value) { BodyStorage::continuous[body] = value; }
+    bool IsContinuous() const { return BodyStorage::continuous[body] != 0; }
+    
+    // Bodies at rest are put to sleep by PhysicsWorld together with
+    // everything they touch, and woken by forces, velocity changes or contact
+    bool IsSleeping() const { return BodyStorage::sleeping[body] != 0; }
+    
+    void WakeUp() {
+        if (BodyStorage::sleeping[body]) {
+            BodyStorage::Wake(body);
+        }
+    }
+    
+    void Sleep() { BodyStorage::Sleep(body); }
+    
+    uint32_t GetBodyIndex() const { return body; }
+    
+private:
+    uint32_t body = BodyStorage::Invalid;
+    
+    void UpdateGravity() {
+        BodyStorage::gravityAccel[body] = 
+            BodyStorage::useGravity[body] ? BodyStorage::gravity[body] : 0.0f;
+        WakeUp();
     }
 };
 
+struct RaycastHit {
+    Collider* collider = nullptr;
+    Vector2 point = {0, 0};
+    Vector2 normal = {0, 0};
+    float distance = 0.0f;
+};
+
+struct PhysicsStats {
+    int colliders = 0;
+    int pairsTested = 0;  // Candidate pairs handed to the narrowphase
+    int pairsHit = 0;
+    int contacts = 0;         // Pairs held in the contact cache
+    int solverContacts = 0;   // Pairs resolved by the impulse solver
+    int sweptBodies = 0;      // Continuous bodies fast enough to be swept
+    int sweptHits = 0;        // Contacts found by sweeps rather than overlap
+    int idleColliders = 0;    // Static or sleeping colliders left out of the broadphase
+    int sleepingBodies = 0;
+    int islands = 0;          // Groups of touching dynamic bodies
+    int solverIslands = 0;    // Independent contact groups solved in parallel
+};
+
+// A touching pair remembered across steps
+struct ContactPair {
+    Collider* a = nullptr;
+    Collider* b = nullptr;
+    bool trigger = false;
+    uint32_t lastStep = 0;  // Last step the pair was seen touching
+    ContactManifold manifold;
+    
+    // Accumulated impulses, reused to warm start the next step
+    float normalImpulse = 0.0f;
+    float tangentImpulse = 0.0f;
+};
+
 class RAYGAME_API PhysicsWorld {
 public:
+    // Colliders register themselves on Start and unregister on OnDestroy
     static void AddCollider(Collider* collider) {
+        if (collider->worldIndex >= 0) return;  // Already registered
+        
+        collider->worldIndex = (int)colliders.size();
+        collider->colliderId = nextColliderId++;
+        collider->attachedRigidbody = collider->GetGameObject()->GetComponent<Rigidbody>();
         colliders.push_back(collider);
+        collider->proxyId = tree.CreateProxy(collider->GetBounds(), collider);
     }
     
     static void RemoveCollider(Collider* collider) {
-        colliders.erase(
-            std::remove(colliders.begin(), colliders.end(), collider),
-            colliders.end()
-        );
+        int index = collider->worldIndex;
+        if (index < 0) return;
+        
+        // Swap-with-last keeps removal O(1)
+        colliders[index] = colliders.back();
+        colliders[index]->worldIndex = index;
+        colliders.pop_back();
+        
+        tree.DestroyProxy(collider->proxyId);
+        collider->proxyId = DynamicAABBTree::Null;
+        collider->worldIndex = -1;
+        
+        ForgetContacts(collider);
+    }
+    
+    // Called by Rigidbody::Start; colliders registered before it get the body
+    static void AttachRigidbody(Rigidbody* body) {
+        for (auto& collider : body->GetGameObject()->GetComponents<Collider>()) {
+            if (!collider->attachedRigidbody) {
+                collider->attachedRigidbody = body;
+            }
+        }
+    }
+    
+    // Called by Rigidbody::OnDestroy; colliders fall back to another body on
+    // the object, if there is one
+    static void DetachRigidbody(Rigidbody* body) {
+        GameObject* owner = body->GetGameObject();
+        Rigidbody* replacement = nullptr;
+        for (auto& other : owner->GetComponents<Rigidbody>()) {
+            if (other.get() != body) {
+                replacement = other.get();
+                break;
+            }
+        }
+        for (auto& collider : owner->GetComponents<Collider>()) {
+            if (collider->attachedRigidbody == body) {
+                collider->attachedRigidbody = replacement;
+            }
+        }
+    }
+    
+    // Advances the simulation: forces change velocities, contacts are solved
+    // against the new velocities, and only then do bodies move
+    static void Step(float dt) {
+        BodyStorage::IntegrateVelocities(dt);
+        FindContacts();
+        SolveVelocities();
+        SweepContinuous(dt);
+        BodyStorage::IntegratePositions(dt);
+        SolvePositions();
+        UpdateIslands(dt);
+        DispatchEvents();
     }
     
+    // Detects and resolves collisions without integrating bodies
     static void CheckCollisions() {
-        for (size_t i = 0; i < colliders.size(); i++) {
-            for (size_t j = i + 1; j < colliders.size(); j++) {
-                if (!colliders[i]->IsEnabled() || !colliders[j]->IsEnabled()) continue;
-                
-                if (colliders[i]->CheckCollision(colliders[j])) {
-                    OnCollision(colliders[i], colliders[j]);
+        FindContacts();
+        SolveVelocities();
+        SolvePositions();
+        DispatchEvents();
+    }
+    
+    static void FindContacts() {
+        stats = PhysicsStats();
+        
+        // Idle colliders (static or asleep, and unmoved since last step) stay
+        // out of the broadphase; they are only found by active colliders
+        broadphase.Clear();
+        candidates.clear();
+        for (auto* collider : colliders) {
+            // Colliders on inactive or destroyed objects find no pairs, so
+            // their cached ones expire below with an Exit
+            if (!IsLive(collider)) {
+                collider->idle = false;
+                continue;
+            }
+            stats.colliders++;
+            
+            Rectangle bounds = collider->GetBounds();
+            bool moved = !SameBounds(bounds, collider->lastBounds);
+            collider->lastBounds = bounds;
+            
+            Rigidbody* rb = collider->attachedRigidbody;
+            if (moved && rb && rb->IsSleeping()) {
+                rb->WakeUp();  // Moved by a script
+            }
+            
+            collider->idle = !moved && !HasAwakeBody(collider);
+            if (moved) {
+                // Only reinserted once the collider leaves its fattened bounds
+                tree.MoveProxy(collider->proxyId, bounds);
+            }
+            
+            if (collider->idle) {
+                stats.idleColliders++;
+                continue;
+            }
+            broadphase.Insert((int)candidates.size(), bounds);
+            candidates.push_back(collider);
+        }
+        
+        // Candidate pairs: active colliders sharing a cell...
+        stepIndex++;
+        pairs.clear();
+        broadphase.ForEachPair([](int a, int b) {
+            AddCandidatePair(candidates[a], candidates[b]);
+        });
+        
+        // ...and active colliders against idle ones nearby
+        for (auto* collider : candidates) {
+            const Rectangle& bounds = collider->lastBounds;
+            tree.Query(bounds, [&](int proxy) {
+                auto* other = static_cast<Collider*>(tree.GetUserData(proxy));
+                if (other->idle && CheckCollisionRecs(bounds, other->lastBounds)) {
+                    AddCandidatePair(collider, other);
                 }
+                return true;
+            });
+        }
+        stats.pairsTested = (int)pairs.size();
+        
+        // Narrowphase across the job system; each thread keeps its own hits
+        narrowphaseHits.resize(JobSystem::GetThreadCount());
+        for (auto& hits : narrowphaseHits) {
+            hits.clear();
+        }
+        
+        JobSystem::ParallelFor(pairs.size(), NarrowphaseBatch, [](size_t begin, size_t end, int thread) {
+            auto& hits = narrowphaseHits[thread];
+            for (size_t i = begin; i < end; i++) {
+                NarrowphaseHit hit;
+                if (Narrowphase::Collide(pairs[i].a, pairs[i].b, hit.manifold)) {
+                    hit.pair = (uint32_t)i;
+                    hits.push_back(hit);
+                }
+            }
+        });
+        
+        // Merged back into pair order so contacts and events don't depend
+        // on how the batches were scheduled
+        mergedHits.clear();
+        for (const auto& hits : narrowphaseHits) {
+            mergedHits.insert(mergedHits.end(), hits.begin(), hits.end());
+        }
+        std::sort(mergedHits.begin(), mergedHits.end(), [](const NarrowphaseHit& a, const NarrowphaseHit& b) {
+            return a.pair < b.pair;
+        });
+        
+        for (const auto& hit : mergedHits) {
+            AddContact(pairs[hit.pair].a, pairs[hit.pair].b, hit.manifold);
+        }
+        stats.pairsHit = (int)mergedHits.size();
+        
+        // Pairs not seen this step have separated, unless neither side could
+        // have moved; those keep their contact without being tested
+        for (auto it = contacts.begin(); it != contacts.end();) {
+            ContactPair& pair = it->second;
+            if (pair.a->idle && pair.b->idle) {
+                pair.lastStep = stepIndex;
+            }
+            if (pair.lastStep == stepIndex) {
+                ++it;
+                continue;
             }
+            
+            QueueEvent(pair.trigger ? EventType::TriggerExit : EventType::CollisionExit, pair.a, pair.b);
+            pair.a->contactCount--;
+            pair.b->contactCount--;
+            it = contacts.erase(it);
         }
+        stats.contacts = (int)contacts.size();
+        stats.solverContacts = (int)solverContacts.size();
+    }
+    
+    // Should be around the size of a typical collider
+    static void SetCellSize(float size) { broadphase.SetCellSize(size); }
+    static float GetCellSize() { return broadphase.GetCellSize(); }
+    
+    static const PhysicsStats& GetStats() { return stats; }
+    
+    // Spatial queries walk the AABB tree, which is refreshed every
+    // CheckCollisions. The tree margin bounds how far a collider may move
+    // between steps and still be found.
+    // layerMask selects which collider layers a query can return.
+    static std::vector<Collider*> QueryRect(const Rectangle& rect, uint32_t layerMask = 0xFFFFFFFFu) {
+        std::vector<Collider*> result;
+        tree.Query(rect, [&](int proxy) {
+            auto* collider = static_cast<Collider*>(tree.GetUserData(proxy));
+            if (!IsLive(collider) || !(layerMask & LayerBit(collider->layer))) return true;
+            if (collider->OverlapsRect(rect)) {
+                result.push_back(collider);
+            }
+            return true;
+        });
+        return result;
+    }
+    
+    static std::vector<Collider*> QueryRadius(Vector2 center, float radius, uint32_t layerMask = 0xFFFFFFFFu) {
+        std::vector<Collider*> result;
+        Rectangle rect = {center.x - radius, center.y - radius, radius * 2, radius * 2};
+        tree.Query(rect, [&](int proxy) {
+            auto* collider = static_cast<Collider*>(tree.GetUserData(proxy));
+            if (!IsLive(collider) || !(layerMask & LayerBit(collider->layer))) return true;
+            if (collider->OverlapsCircle(center, radius)) {
+                result.push_back(collider);
+            }
+            return true;
+        });
+        return result;
+    }
+    
+    // Finds the closest collider along the ray
+    static bool Raycast(Vector2 origin, Vector2 direction, float maxDistance, RaycastHit& hit,
+                        uint32_t layerMask = 0xFFFFFFFFu) {
+        Vector2 dir = Normalize(direction);
+        if (dir.x == 0 && dir.y == 0) return false;
+        
+        Vector2 end = {origin.x + dir.x * maxDistance, origin.y + dir.y * maxDistance};
+        bool found = false;
+        
+        tree.RayCast(origin, end, [&](int proxy, float maxFraction) {
+            auto* collider = static_cast<Collider*>(tree.GetUserData(proxy));
+            if (!IsLive(collider) || !(layerMask & LayerBit(collider->layer))) {
+                return maxFraction;
+            }
+            
+            float distance;
+            Vector2 normal;
+            if (!collider->Raycast(origin, dir, maxFraction * maxDistance, distance, normal)) {
+                return maxFraction;
+            }
+            
+            found = true;
+            hit.collider = collider;
+            hit.distance = distance;
+            hit.normal = normal;
+            hit.point = {origin.x + dir.x * distance, origin.y + dir.y * distance};
+            return distance / maxDistance;
+        });
+        
+        return found;
+    }
+    
+    static void SetTreeMargin(float margin) { tree.SetMargin(margin); }
+    
+    // Solver settings. Warm starting lets a small iteration count converge.
+    static void SetSolverIterations(int value) { solverIterations = std::max(1, value); }
+    static int GetSolverIterations() { return solverIterations; }
+    static void SetRestitution(float value) { restitution = value; }
+    static void SetFriction(float value) { friction = value; }
+    
+    // Sleeping settings. Islands of touching bodies slower than the sleep
+    // speed for timeToSleep seconds stop being integrated and tested.
+    static void SetSleepingEnabled(bool value) { sleepingEnabled = value; }
+    static void SetSleepThreshold(float speed, float seconds) {
+        sleepSpeed = speed;
+        timeToSleep = seconds;
     }
     
     static void DebugDraw() {
@@ -182,49 +857,677 @@ public:
                 collider->DebugDraw();
             }
         }
+        
+        for (const auto& entry : contacts) {
+            const ContactManifold& m = entry.second.manifold;
+            for (int i = 0; i < m.pointCount; i++) {
+                Vector2 p = m.points[i];
+                DrawCircleV(p, 2, RED);
+                DrawLineV(p, {p.x + m.normal.x * 10, p.y + m.normal.y * 10}, RED);
+            }
+        }
     }
     
     static void Clear() {
+        for (auto* collider : colliders) {
+            collider->proxyId = DynamicAABBTree::Null;
+            collider->worldIndex = -1;
+            collider->contactCount = 0;
+            collider->lastBounds = {0, 0, -1, -1};
+            collider->idle = false;
+        }
+        contacts.clear();
+        events.clear();
+        solverContacts.clear();
+        solverIslands.clear();
+        tree.Clear();
+        
         colliders.clear();
+        candidates.clear();
+        broadphase.Clear();
+        stats = PhysicsStats();
     }
     
 private:
     static inline std::vector<Collider*> colliders;
+    static inline std::vector<Collider*> candidates;  // Active colliders, indexed by broadphase id
+    
+    // Narrowphase work for the current step
+    static constexpr size_t NarrowphaseBatch = 64;
+    
+    struct CandidatePair {
+        Collider* a;
+        Collider* b;
+    };
+    
+    struct NarrowphaseHit {
+        uint32_t pair;  // Index into pairs
+        ContactManifold manifold;
+    };
+    
+    static inline std::vector<CandidatePair> pairs;
+    static inline std::vector<std::vector<NarrowphaseHit>> narrowphaseHits;  // Per thread
+    static inline std::vector<NarrowphaseHit> mergedHits;
+    static inline SpatialHash broadphase;
+    static inline DynamicAABBTree tree;
+    static inline PhysicsStats stats;
+    
+    // Contact cache keyed by collider id pair
+    static inline std::unordered_map<uint64_t, ContactPair> contacts;
+    static inline uint32_t nextColliderId = 1;
+    static inline uint32_t stepIndex = 0;
+    
+    enum class EventType {
+        CollisionEnter,
+        CollisionStay,
+        CollisionExit,
+        TriggerEnter,
+        TriggerExit
+    };
+    
+    struct PendingEvent {
+        EventType type;
+        Collider* a;
+        Collider* b;
+    };
+    
+    // Events are sent after the pass so callbacks can't disturb it
+    static inline std::vector<PendingEvent> events;
+    
+    static bool SameBounds(const Rectangle& a, const Rectangle& b) {
+        return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+    }
+    
+    // Enabled, on an object that is active and not destroyed
+    static bool IsLive(const Collider* collider) {
+        return collider->IsEnabled() && collider->GetGameObject()->active;
+    }
+    
+    static bool HasAwakeBody(const Collider* collider) {
+        Rigidbody* rb = collider->attachedRigidbody;
+        return rb && rb->IsEnabled() && !rb->IsKinematic() && !rb->IsSleeping();
+    }
+    
+    static void AddCandidatePair(Collider* a, Collider* b) {
+        // Layer filtering happens before any narrowphase work
+        if (a->CanCollideWith(b)) {
+            pairs.push_back({a, b});
+        }
+    }
+    
+    static void AddContact(Collider* a, Collider* b, const ContactManifold& manifold) {
+        ContactPair& pair = TouchContact(a, b);
+        pair.manifold = manifold;
+        if (pair.trigger) return;
+        
+        // Something active touched a sleeping body; its island wakes after the step
+        if (a->attachedRigidbody && a->attachedRigidbody->IsSleeping()) a->attachedRigidbody->WakeUp();
+        if (b->attachedRigidbody && b->attachedRigidbody->IsSleeping()) b->attachedRigidbody->WakeUp();
+        
+        AddSolverContact(pair);
+    }
+    
+    static uint64_t PairKey(const Collider* a, const Collider* b) {
+        uint32_t lo = std::min(a->colliderId, b->colliderId);
+        uint32_t hi = std::max(a->colliderId, b->colliderId);
+        return ((uint64_t)hi << 32) | lo;
+    }
+    
+    static ContactPair& TouchContact(Collider* a, Collider* b) {
+        auto result = contacts.try_emplace(PairKey(a, b));
+        ContactPair& pair = result.first->second;
+        pair.lastStep = stepIndex;
+        
+        if (result.second) {
+            pair.a = a;
+            pair.b = b;
+            pair.trigger = a->isTrigger || b->isTrigger;
+            a->contactCount++;
+            b->contactCount++;
+            QueueEvent(pair.trigger ? EventType::TriggerEnter : EventType::CollisionEnter, a, b);
+        } else if (!pair.trigger) {
+            QueueEvent(EventType::CollisionStay, a, b);
+        }
+        
+        // The cached pair may list the colliders the other way round. The
+        // new manifold's normal and tangent already point the new way, so
+        // the accumulated impulses keep their sign.
+        if (pair.a != a) {
+            std::swap(pair.a, pair.b);
+        }
+        return pair;
+    }
+    
+    // Drops cached pairs (and undelivered events) that reference a collider
+    static void ForgetContacts(Collider* collider) {
+        for (auto& event : events) {
+            if (event.a == collider || event.b == collider) {
+                event.a = event.b = nullptr;
+            }
+        }
+        
+        if (collider->contactCount == 0) return;
+        
+        for (auto it = contacts.begin(); it != contacts.end();) {
+            ContactPair& pair = it->second;
+            if (pair.a != collider && pair.b != collider) {
+                ++it;
+                continue;
+            }
+            
+            pair.a->contactCount--;
+            pair.b->contactCount--;
+            it = contacts.erase(it);
+        }
+    }
     
-    static void OnCollision(Collider* a, Collider* b) {
-        // Simple collision response for non-triggers
-        if (a->isTrigger || b->isTrigger) return;
+    static void ForgetPair(Collider* a, Collider* b) {
+        auto it = contacts.find(PairKey(a, b));
+        if (it == contacts.end()) return;
         
-        auto* rbA = a->GetGameObject()->GetComponent<Rigidbody>().get();
-        auto* rbB = b->GetGameObject()->GetComponent<Rigidbody>().get();
+        a->contactCount--;
+        b->contactCount--;
+        contacts.erase(it);
+    }
+    
+    static void QueueEvent(EventType type, Collider* a, Collider* b) {
+        events.push_back({type, a, b});
+    }
+    
+    static void DispatchEvents() {
+        // Index-based: a callback destroying a collider nulls its pending events
+        for (size_t i = 0; i < events.size(); i++) {
+            PendingEvent event = events[i];
+            if (!event.a || !event.b) continue;
+            
+            // An earlier callback may have deactivated or destroyed one side.
+            // Pairs it never entered are dropped; the rest expire next step.
+            bool entering = event.type == EventType::CollisionEnter || event.type == EventType::TriggerEnter;
+            if ((entering || event.type == EventType::CollisionStay) && !(IsLive(event.a) && IsLive(event.b))) {
+                if (entering) ForgetPair(event.a, event.b);
+                continue;
+            }
+            
+            SendEvent(event.type, event.a, event.b);
+            if (events[i].a && events[i].b) {
+                SendEvent(event.type, event.b, event.a);
+            }
+        }
+        events.clear();
+    }
+    
+    static void SendEvent(EventType type, Collider* self, Collider* other) {
+        GameObject* obj = self->GetGameObject();
+        if (!obj) return;
         
-        if (rbA && rbB && !rbA->isKinematic && !rbB->isKinematic) {
-            // Simple elastic collision
-            Vector2 normal = Normalize({
-                b->GetWorldPosition().x - a->GetWorldPosition().x,
-                b->GetWorldPosition().y - a->GetWorldPosition().y
+        const auto& components = obj->GetAllComponents();
+        for (size_t i = 0; i < components.size(); i++) {
+            Component* comp = components[i].get();
+            if (!comp->IsEnabled()) continue;
+            
+            switch (type) {
+                case EventType::CollisionEnter: comp->OnCollisionEnter(other); break;
+                case EventType::CollisionStay:  comp->OnCollisionStay(other); break;
+                case EventType::CollisionExit:  comp->OnCollisionExit(other); break;
+                case EventType::TriggerEnter:   comp->OnTriggerEnter(other); break;
+                case EventType::TriggerExit:    comp->OnTriggerExit(other); break;
+            }
+        }
+    }
+    
+    // Sequential impulse solver state
+    struct SolverContact {
+        ContactPair* pair;
+        uint32_t bodyA, bodyB;  // BodyStorage index, Invalid for static colliders
+        float invMassA, invMassB;
+        Transform* transformA;
+        Transform* transformB;
+        Vector2 startA, startB;  // Positions when the manifold was built
+        float normalMass;
+        float velocityBias;     // Target separating speed from restitution
+    };
+    
+    static inline std::vector<SolverContact> solverContacts;
+    
+    // Contiguous range of solverContacts touching one group of bodies
+    struct SolverIsland {
+        uint32_t begin, end;
+    };
+    
+    static constexpr size_t IslandBatch = 4;
+    static inline std::vector<SolverIsland> solverIslands;
+    static inline std::vector<SolverContact> islandContacts;  // Regrouping scratch
+    static inline std::vector<uint32_t> contactIslands;
+    static inline std::vector<int32_t> islandSlots;           // Island per root body, -1 if none
+    
+    struct SweepHit {
+        Collider* other;
+        float toi;
+        Vector2 normal;
+        float distance;  // Length of the relative motion
+    };
+    
+    static inline std::vector<SweepHit> sweepHits;
+    static inline int solverIterations = 8;
+    static inline float restitution = 0.8f;          // Bounciness
+    static inline float friction = 0.0f;
+    static inline float restitutionThreshold = 20.0f;  // Slower impacts don't bounce
+    static inline float penetrationSlop = 0.5f;        // Allowed overlap in pixels
+    static inline float correctionPercent = 0.2f;      // Overlap removed per position iteration
+    static inline int positionIterations = 3;
+    
+    // Sleeping
+    static inline bool sleepingEnabled = true;
+    static inline float sleepSpeed = 5.0f;    // Pixels per second
+    static inline float timeToSleep = 0.5f;   // Seconds at rest before sleeping
+    static inline std::vector<uint32_t> islandParent;
+    static inline std::vector<float> islandRestTime;
+    
+    static uint32_t DynamicBody(Collider* collider, float& invMass) {
+        Rigidbody* rb = collider->attachedRigidbody;
+        if (!rb || !rb->IsEnabled() || rb->IsKinematic() || rb->IsSleeping()) {
+            invMass = 0.0f;
+            return BodyStorage::Invalid;
+        }
+        
+        invMass = rb->GetInverseMass();
+        return rb->GetBodyIndex();
+    }
+    
+    static void AddSolverContact(ContactPair& pair) {
+        SolverContact c;
+        c.pair = &pair;
+        c.bodyA = DynamicBody(pair.a, c.invMassA);
+        c.bodyB = DynamicBody(pair.b, c.invMassB);
+        
+        float invMassSum = c.invMassA + c.invMassB;
+        if (invMassSum <= 0.0f) {
+            // Neither side can move; nothing to resolve or warm start
+            pair.normalImpulse = 0;
+            pair.tangentImpulse = 0;
+            return;
+        }
+        
+        c.transformA = pair.a->GetGameObject()->transform.get();
+        c.transformB = pair.b->GetGameObject()->transform.get();
+        c.startA = c.transformA->position;
+        c.startB = c.transformB->position;
+        c.normalMass = 1.0f / invMassSum;
+        c.velocityBias = 0.0f;
+        solverContacts.push_back(c);
+    }
+    
+    static Vector2 BodyVelocity(uint32_t body) {
+        if (body == BodyStorage::Invalid) return {0, 0};
+        return {BodyStorage::velX[body], BodyStorage::velY[body]};
+    }
+    
+    static Vector2 PreviousVelocity(uint32_t body) {
+        if (body == BodyStorage::Invalid) return {0, 0};
+        return {BodyStorage::prevVelX[body], BodyStorage::prevVelY[body]};
+    }
+    
+    static void ApplyImpulse(const SolverContact& c, Vector2 impulse) {
+        if (c.bodyA != BodyStorage::Invalid) {
+            BodyStorage::velX[c.bodyA] -= impulse.x * c.invMassA;
+            BodyStorage::velY[c.bodyA] -= impulse.y * c.invMassA;
+        }
+        if (c.bodyB != BodyStorage::Invalid) {
+            BodyStorage::velX[c.bodyB] += impulse.x * c.invMassB;
+            BodyStorage::velY[c.bodyB] += impulse.y * c.invMassB;
+        }
+    }
+    
+    // Splits solver contacts into islands of bodies linked by contacts.
+    // Islands share no dynamic body, so they are solved in parallel; each
+    // keeps its contacts in order, so results don't depend on thread count.
+    static void BuildSolverIslands() {
+        solverIslands.clear();
+        if (solverContacts.empty()) return;
+        
+        const uint32_t n = (uint32_t)BodyStorage::Count();
+        islandParent.resize(n);
+        islandSlots.resize(n, -1);
+        for (const auto& c : solverContacts) {
+            if (c.bodyA != BodyStorage::Invalid) islandParent[c.bodyA] = c.bodyA;
+            if (c.bodyB != BodyStorage::Invalid) islandParent[c.bodyB] = c.bodyB;
+        }
+        for (const auto& c : solverContacts) {
+            if (c.bodyA != BodyStorage::Invalid && c.bodyB != BodyStorage::Invalid) {
+                islandParent[FindIsland(c.bodyA)] = FindIsland(c.bodyB);
+            }
+        }
+        
+        // Number islands by first appearance and count their contacts
+        contactIslands.resize(solverContacts.size());
+        for (size_t i = 0; i < solverContacts.size(); i++) {
+            const SolverContact& c = solverContacts[i];
+            int32_t& slot = islandSlots[FindIsland(c.bodyA != BodyStorage::Invalid ? c.bodyA : c.bodyB)];
+            if (slot < 0) {
+                slot = (int32_t)solverIslands.size();
+                solverIslands.push_back({0, 0});
+            }
+            contactIslands[i] = (uint32_t)slot;
+            solverIslands[slot].end++;
+        }
+        
+        // Counts become ranges, then contacts are regrouped by island
+        uint32_t offset = 0;
+        for (auto& island : solverIslands) {
+            uint32_t count = island.end;
+            island.begin = island.end = offset;
+            offset += count;
+        }
+        
+        islandContacts.resize(solverContacts.size());
+        for (size_t i = 0; i < solverContacts.size(); i++) {
+            islandContacts[solverIslands[contactIslands[i]].end++] = solverContacts[i];
+        }
+        solverContacts.swap(islandContacts);
+        
+        for (const auto& c : solverContacts) {
+            islandSlots[FindIsland(c.bodyA != BodyStorage::Invalid ? c.bodyA : c.bodyB)] = -1;
+        }
+        stats.solverIslands = (int)solverIslands.size();
+    }
+    
+    static void SolveVelocities() {
+        BuildSolverIslands();
+        JobSystem::ParallelFor(solverIslands.size(), IslandBatch, [](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+                SolveIslandVelocities(solverIslands[i]);
+            }
+        });
+    }
+    
+    static void SolveIslandVelocities(const SolverIsland& island) {
+        // Bodies don't rotate, so every point of a manifold shares the same
+        // Jacobian and one normal + one tangent constraint per pair suffices
+        for (uint32_t i = island.begin; i < island.end; i++) {
+            SolverContact& c = solverContacts[i];
+            const ContactManifold& m = c.pair->manifold;
+            Vector2 tangent = {-m.normal.y, m.normal.x};
+            
+            // Bounce off the approach speed from before this step's forces;
+            // including them would let gravity feed an endless small bounce
+            Vector2 vA = PreviousVelocity(c.bodyA);
+            Vector2 vB = PreviousVelocity(c.bodyB);
+            float vn = (vB.x - vA.x) * m.normal.x + (vB.y - vA.y) * m.normal.y;
+            if (vn < -restitutionThreshold) {
+                c.velocityBias = -restitution * vn;
+            }
+            
+            // Warm start with last step's impulses
+            ApplyImpulse(c, {
+                m.normal.x * c.pair->normalImpulse + tangent.x * c.pair->tangentImpulse,
+                m.normal.y * c.pair->normalImpulse + tangent.y * c.pair->tangentImpulse
             });
+        }
+        
+        for (int iteration = 0; iteration < solverIterations; iteration++) {
+            for (uint32_t i = island.begin; i < island.end; i++) {
+                SolverContact& c = solverContacts[i];
+                const ContactManifold& m = c.pair->manifold;
+                Vector2 tangent = {-m.normal.y, m.normal.x};
+                
+                // Normal: accumulated impulse is clamped, never pulls bodies together
+                Vector2 vA = BodyVelocity(c.bodyA);
+                Vector2 vB = BodyVelocity(c.bodyB);
+                float vn = (vB.x - vA.x) * m.normal.x + (vB.y - vA.y) * m.normal.y;
+                
+                float lambda = c.normalMass * (c.velocityBias - vn);
+                float oldImpulse = c.pair->normalImpulse;
+                c.pair->normalImpulse = std::max(oldImpulse + lambda, 0.0f);
+                lambda = c.pair->normalImpulse - oldImpulse;
+                ApplyImpulse(c, {m.normal.x * lambda, m.normal.y * lambda});
+                
+                if (friction <= 0.0f) continue;
+                
+                // Friction: bounded by the normal impulse
+                vA = BodyVelocity(c.bodyA);
+                vB = BodyVelocity(c.bodyB);
+                float vt = (vB.x - vA.x) * tangent.x + (vB.y - vA.y) * tangent.y;
+                
+                float maxFriction = friction * c.pair->normalImpulse;
+                float lambdaT = -c.normalMass * vt;
+                float oldTangent = c.pair->tangentImpulse;
+                c.pair->tangentImpulse = Clamp(oldTangent + lambdaT, -maxFriction, maxFriction);
+                lambdaT = c.pair->tangentImpulse - oldTangent;
+                ApplyImpulse(c, {tangent.x * lambdaT, tangent.y * lambdaT});
+            }
+        }
+    }
+    
+    static bool IsTouching(const Collider* a, const Collider* b) {
+        auto it = contacts.find(PairKey(a, b));
+        return it != contacts.end() && it->second.lastStep == stepIndex;
+    }
+    
+    // Casts continuous bodies along this step's motion. Triggers crossed on
+    // the way are reported; the first solid hit stops the body at its time of
+    // impact, leaving the contact to the solver next step.
+    static void SweepContinuous(float dt) {
+        for (auto* collider : candidates) {
+            Rigidbody* rb = collider->attachedRigidbody;
+            if (!rb || !rb->IsContinuous()) continue;
+            
+            float invMass;
+            uint32_t body = DynamicBody(collider, invMass);
+            if (body == BodyStorage::Invalid) continue;
+            
+            Vector2 velocity = BodyVelocity(body);
+            Vector2 move = {velocity.x * dt, velocity.y * dt};
             
-            Vector2 relVel = {
-                rbA->velocity.x - rbB->velocity.x,
-                rbA->velocity.y - rbB->velocity.y
+            // Moving less than half its own size, discrete overlap can't miss
+            Rectangle bounds = collider->GetBounds();
+            float extent = std::min(bounds.width, bounds.height) * 0.5f;
+            if (std::fabs(move.x) < extent && std::fabs(move.y) < extent) continue;
+            
+            stats.sweptBodies++;
+            Rectangle swept = {
+                std::min(bounds.x, bounds.x + move.x), std::min(bounds.y, bounds.y + move.y),
+                bounds.width + std::fabs(move.x), bounds.height + std::fabs(move.y)
             };
             
-            float velAlongNormal = relVel.x * normal.x + relVel.y * normal.y;
+            sweepHits.clear();
+            tree.Query(swept, [&](int proxy) {
+                auto* other = static_cast<Collider*>(tree.GetUserData(proxy));
+                if (other == collider || !IsLive(other) ||
+                    other->GetGameObject() == collider->GetGameObject() ||
+                    !collider->CanCollideWith(other) || IsTouching(collider, other)) {
+                    return true;
+                }
+                
+                // Cast with the relative motion when the other side moves too
+                float otherInvMass;
+                Vector2 otherVelocity = BodyVelocity(DynamicBody(other, otherInvMass));
+                Vector2 relative = {move.x - otherVelocity.x * dt, move.y - otherVelocity.y * dt};
+                
+                SweepHit hit;
+                hit.other = other;
+                hit.distance = std::sqrt(relative.x * relative.x + relative.y * relative.y);
+                if (Narrowphase::Sweep(collider, relative, other, hit.toi, hit.normal)) {
+                    sweepHits.push_back(hit);
+                }
+                return true;
+            });
             
-            if (velAlongNormal > 0) return;  // Objects moving apart
+            std::stable_sort(sweepHits.begin(), sweepHits.end(), [](const SweepHit& a, const SweepHit& b) {
+                return a.toi < b.toi;
+            });
             
-            float restitution = 0.8f;  // Bounciness
-            float j = -(1 + restitution) * velAlongNormal;
-            j /= 1/rbA->mass + 1/rbB->mass;
+            for (const auto& hit : sweepHits) {
+                // Contact point on the swept shape's surface at the time of impact
+                Vector2 center = collider->GetWorldPosition();
+                float reach = std::fabs(hit.normal.x) * bounds.width * 0.5f +
+                              std::fabs(hit.normal.y) * bounds.height * 0.5f;
+                
+                ContactPair& pair = TouchContact(collider, hit.other);
+                pair.manifold = ContactManifold();
+                pair.manifold.normal = hit.normal;
+                pair.manifold.points[0] = {
+                    center.x + move.x * hit.toi + hit.normal.x * reach,
+                    center.y + move.y * hit.toi + hit.normal.y * reach
+                };
+                pair.manifold.pointCount = 1;
+                stats.sweptHits++;
+                
+                if (pair.trigger) continue;
+                
+                // Stop just inside the slop so next step's narrowphase keeps the contact
+                float toi = std::min(1.0f, hit.toi + penetrationSlop * 0.5f / hit.distance);
+                BodyStorage::timeOfImpact[body] = std::min(BodyStorage::timeOfImpact[body], toi);
+                break;
+            }
+        }
+    }
+    
+    // Pushes overlapping bodies apart. Separation is re-measured from how far
+    // each body has moved since detection, so corrections propagate through stacks.
+    static void SolvePositions() {
+        JobSystem::ParallelFor(solverIslands.size(), IslandBatch, [](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+                SolveIslandPositions(solverIslands[i]);
+            }
+        });
+        
+        solverContacts.clear();
+        solverIslands.clear();
+    }
+    
+    static void SolveIslandPositions(const SolverIsland& island) {
+        for (int iteration = 0; iteration < positionIterations; iteration++) {
+            for (uint32_t i = island.begin; i < island.end; i++) {
+                SolverContact& c = solverContacts[i];
+                const ContactManifold& m = c.pair->manifold;
+                Vector2 moveA = {c.transformA->position.x - c.startA.x, c.transformA->position.y - c.startA.y};
+                Vector2 moveB = {c.transformB->position.x - c.startB.x, c.transformB->position.y - c.startB.y};
+                float depth = m.depth - ((moveB.x - moveA.x) * m.normal.x + (moveB.y - moveA.y) * m.normal.y);
+                
+                float correction = std::max(depth - penetrationSlop, 0.0f) * correctionPercent * c.normalMass;
+                if (correction <= 0.0f) continue;
+                
+                if (c.bodyA != BodyStorage::Invalid) {
+                    c.transformA->position.x -= m.normal.x * correction * c.invMassA;
+                    c.transformA->position.y -= m.normal.y * correction * c.invMassA;
+                }
+                if (c.bodyB != BodyStorage::Invalid) {
+                    c.transformB->position.x += m.normal.x * correction * c.invMassB;
+                    c.transformB->position.y += m.normal.y * correction * c.invMassB;
+                }
+            }
+        }
+    }
+    
+    static uint32_t FindIsland(uint32_t body) {
+        while (islandParent[body] != body) {
+            islandParent[body] = islandParent[islandParent[body]];  // Path halving
+            body = islandParent[body];
+        }
+        return body;
+    }
+    
+    // Bodies that can take part in islands: dynamic, whether awake or asleep
+    static uint32_t IslandBody(const Collider* collider) {
+        Rigidbody* rb = collider->attachedRigidbody;
+        if (!rb || !rb->IsEnabled() || !collider->GetGameObject()->active || rb->IsKinematic()) {
+            return BodyStorage::Invalid;
+        }
+        return rb->GetBodyIndex();
+    }
+    
+    // Groups bodies connected by solid contacts into islands. An island falls
+    // asleep once every body in it has been slow for timeToSleep, and wakes
+    // as a whole as soon as any of its bodies is awake and moving.
+    static void UpdateIslands(float dt) {
+        const uint32_t n = (uint32_t)BodyStorage::Count();
+        if (n == 0) return;
+        
+        islandParent.resize(n);
+        for (uint32_t i = 0; i < n; i++) {
+            islandParent[i] = i;
+        }
+        
+        for (const auto& entry : contacts) {
+            const ContactPair& pair = entry.second;
+            if (pair.trigger) continue;
+            
+            uint32_t a = IslandBody(pair.a);
+            uint32_t b = IslandBody(pair.b);
+            if (a == BodyStorage::Invalid || b == BodyStorage::Invalid) continue;
+            islandParent[FindIsland(a)] = FindIsland(b);
+        }
+        
+        // Per-body rest timers, reduced to the shortest one per island root
+        const float sleepSpeedSq = sleepSpeed * sleepSpeed;
+        islandRestTime.assign(n, -1.0f);  // Negative: not simulated
+        for (uint32_t i = 0; i < n; i++) {
+            bool asleep = BodyStorage::sleeping[i] != 0;
+            if (!asleep && BodyStorage::simulate[i] == 0.0f) continue;
+            
+            if (!asleep) {
+                float speedSq = BodyStorage::velX[i] * BodyStorage::velX[i] +
+                                BodyStorage::velY[i] * BodyStorage::velY[i];
+                BodyStorage::sleepTime[i] = speedSq < sleepSpeedSq ? BodyStorage::sleepTime[i] + dt : 0.0f;
+            }
             
-            Vector2 impulse = {normal.x * j, normal.y * j};
+            // Sleepers count as fully rested; with sleeping off nobody rests
+            float rest = asleep ? timeToSleep : (sleepingEnabled ? BodyStorage::sleepTime[i] : 0.0f);
+            float& island = islandRestTime[FindIsland(i)];
+            if (island < 0.0f) {
+                island = rest;
+                stats.islands++;
+            } else {
+                island = std::min(island, rest);
+            }
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t root = FindIsland(i);
+            float rest = islandRestTime[root];
+            bool asleep = BodyStorage::sleeping[i] != 0;
+            if (!asleep && BodyStorage::simulate[i] == 0.0f) continue;
             
-            rbA->AddImpulse({-impulse.x, -impulse.y});
-            rbB->AddImpulse(impulse);
+            if (rest >= timeToSleep) {
+                if (!asleep) BodyStorage::Sleep(i);
+                stats.sleepingBodies++;
+            } else if (asleep) {
+                BodyStorage::Wake(i);
+            }
+        }
+        
+        // Position correction may have nudged bodies that just fell asleep;
+        // settle their bounds so they aren't mistaken for moved next step
+        for (auto* collider : candidates) {
+            Rigidbody* rb = collider->attachedRigidbody;
+            if (rb && rb->IsSleeping()) {
+                collider->lastBounds = collider->GetBounds();
+            }
         }
     }
 };
 
+inline bool Collider::CheckCollision(Collider* other) {
+    ContactManifold manifold;
+    return Narrowphase::Collide(this, other, manifold);
+}
+
+inline void Collider::Start() {
+    PhysicsWorld::AddCollider(this);
+}
+
+inline void Collider::OnDestroy() {
+    PhysicsWorld::RemoveCollider(this);
+}
+
+inline void Rigidbody::Start() {
+    PhysicsWorld::AttachRigidbody(this);
+}
+
+inline void Rigidbody::OnDestroy() {
+    PhysicsWorld::DetachRigidbody(this);
+    BodyStorage::Detach(body);
+}
+
 }
 
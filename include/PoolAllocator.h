@@ -0,0 +1,158 @@
+#pragma once
+
+#include "Core.h"
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <typeinfo>
+
+namespace RayGame {
+
+struct PoolStats {
+    const char* name = "";      // Compiler-specific, for debugging
+    size_t blockSize = 0;
+    size_t chunkCount = 0;
+    size_t capacity = 0;        // Blocks in all chunks
+    size_t used = 0;
+    size_t peak = 0;
+};
+
+// Fixed-size blocks carved out of chunks that grow geometrically. Freed
+// blocks go onto a free list and are handed out again first; chunks are
+// kept for the life of the program, so a steady spawn/despawn rate settles
+// on a fixed footprint instead of fragmenting the heap.
+class RAYGAME_API BlockPool {
+public:
+    BlockPool(const char* name, size_t size, size_t align)
+        : blockAlign(std::max(align, alignof(FreeBlock))) {
+        stats.name = name;
+        // Every block must hold a free-list link and keep the next one aligned
+        size = std::max(size, sizeof(FreeBlock));
+        stats.blockSize = (size + blockAlign - 1) / blockAlign * blockAlign;
+    }
+    
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+    
+    void* Allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeList) AddChunk();
+        
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        stats.used++;
+        stats.peak = std::max(stats.peak, stats.used);
+        return block;
+    }
+    
+    void Free(void* pointer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = freeList;
+        freeList = block;
+        stats.used--;
+    }
+    
+    PoolStats GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    
+    static constexpr size_t FirstChunkBlocks = 32;
+    static constexpr size_t MaxChunkBlocks = 1024;
+    
+    mutable std::mutex mutex;
+    size_t blockAlign;
+    FreeBlock* freeList = nullptr;
+    PoolStats stats;
+    
+    // Doubles the pool's capacity, up to MaxChunkBlocks per chunk. Blocks
+    // are threaded in address order, so fresh allocations walk the chunk.
+    void AddChunk() {
+        size_t blocks = std::min(MaxChunkBlocks, std::max(FirstChunkBlocks, stats.capacity));
+        auto* chunk = static_cast<unsigned char*>(
+            ::operator new(blocks * stats.blockSize, std::align_val_t(blockAlign)));
+        
+        for (size_t i = blocks; i-- > 0;) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * stats.blockSize);
+            block->next = freeList;
+            freeList = block;
+        }
+        stats.chunkCount++;
+        stats.capacity += blocks;
+    }
+};
+
+// One BlockPool per allocated type, created on first use and never
+// destroyed, so blocks may be freed during static destruction
+class RAYGAME_API BlockPools {
+public:
+    template<typename T>
+    static BlockPool& For() {
+        static BlockPool* pool = Register(new BlockPool(typeid(T).name(), sizeof(T), alignof(T)));
+        return *pool;
+    }
+    
+    static std::vector<PoolStats> GetStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<PoolStats> result;
+        result.reserve(pools.size());
+        for (BlockPool* pool : pools) {
+            result.push_back(pool->GetStats());
+        }
+        return result;
+    }
+
+private:
+    static inline std::mutex mutex;
+    static inline std::vector<BlockPool*> pools;
+    
+    static BlockPool* Register(BlockPool* pool) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pools.push_back(pool);
+        return pool;
+    }
+};
+
+// Standard allocator over BlockPools. std::allocate_shared rebinds it to
+// its combined control block + object type, so each Ref<T> costs one pool
+// block instead of a trip through malloc.
+template<typename T>
+struct PoolAllocator {
+    using value_type = T;
+    
+    PoolAllocator() = default;
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+    
+    T* allocate(size_t count) {
+        if (count != 1) return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        return static_cast<T*>(BlockPools::For<T>().Allocate());
+    }
+    
+    void deallocate(T* pointer, size_t count) {
+        if (count != 1) {
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+            return;
+        }
+        BlockPools::For<T>().Free(pointer);
+    }
+    
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>&) const { return false; }
+};
+
+// CreateRef with the object and its reference counts in a pooled block
+template<typename T, typename... Args>
+Ref<T> CreatePooledRef(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+}
@@ -3,14 +3,27 @@
 // Main include file for RayGame Engine
 
 #include "Core.h"
+#include "JobSystem.h"
+#include "Rng.h"
 #include "Time.h"
 #include "Input.h"
+#include "StringId.h"
+#include "PoolAllocator.h"
+#include "ComponentType.h"
 #include "Component.h"
 #include "GameObject.h"
+#include "ArchetypeStorage.h"
+#include "CommandBuffer.h"
 #include "Scene.h"
 #include "Camera2D.h"
 #include "Sprite.h"
+#include "ParticleBuffer.h"
+#include "ParticleRenderer.h"
 #include "ParticleSystem.h"
+#include "ParticleSystemManager.h"
+#include "SpatialHash.h"
+#include "AABBTree.h"
+#include "BodyStorage.h"
 #include "Physics.h"
 #include "ResourceManager.h"
 #include "GameEngine.h"
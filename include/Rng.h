@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Core.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+namespace RayGame {
+
+// Small, fast xoshiro128** generator. Generators seeded with the same
+// seed and stream produce the same sequence on every platform; different
+// streams of one seed are independent.
+class RAYGAME_API Rng {
+public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        Seed(seed, stream);
+    }
+    
+    void Seed(uint64_t seed, uint64_t stream = 0) {
+        uint64_t streamMixer = stream;
+        uint64_t mixer = seed ^ SplitMix(streamMixer);
+        for (int i = 0; i < 2; i++) {
+            uint64_t value = SplitMix(mixer);
+            state[2 * i] = (uint32_t)value;
+            state[2 * i + 1] = (uint32_t)(value >> 32);
+        }
+        lanesSeeded = false;
+    }
+    
+    uint32_t Next() {
+        return Step(state[0], state[1], state[2], state[3]);
+    }
+    
+    // [0, 1), with 24 bits of precision
+    float NextFloat() {
+        return (Next() >> 8) * (1.0f / 16777216.0f);
+    }
+    
+    float Range(float min, float max) {
+        return min + NextFloat() * (max - min);
+    }
+    
+    // [min, max], both inclusive
+    int Range(int min, int max) {
+        if (min >= max) return min;
+        uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+        return (int)(min + (int64_t)(((uint64_t)Next() * span) >> 32));
+    }
+    
+    Vector2 Range(Vector2 min, Vector2 max) {
+        float x = Range(min.x, max.x);
+        return {x, Range(min.y, max.y)};
+    }
+    
+    // Fills out[0..count) with floats between min and max, or with min if
+    // max <= min, like Random(). Runs eight independent generators side by
+    // side, so the loop vectorizes; they are seeded from this generator on
+    // first use, so sequences stay reproducible.
+    void Fill(float* out, size_t count, float min, float max) {
+        if (min >= max) {
+            std::fill(out, out + count, min);
+            return;
+        }
+        if (!lanesSeeded) SeedLanes();
+        
+        float scale = (max - min) * (1.0f / 16777216.0f);
+        size_t i = 0;
+        for (; i + LaneCount <= count; i += LaneCount) {
+            NextLanes(out + i, min, scale);
+        }
+        if (i < count) {
+            float tail[LaneCount];
+            NextLanes(tail, min, scale);
+            for (size_t k = 0; i < count; i++, k++) out[i] = tail[k];
+        }
+    }
+    
+    // The calling thread's generator. Job system threads get one stream
+    // each; threads outside the pool share stream 0's seed with the main
+    // thread. Reseeded by SetGlobalSeed.
+    static Rng& ThreadLocal() {
+        thread_local Rng rng;
+        thread_local uint64_t epoch = 0;  // Global epochs start at 1
+        
+        uint64_t current = globalEpoch.load(std::memory_order_acquire);
+        if (epoch != current) {
+            rng.Seed(globalSeed.load(), (uint64_t)JobSystem::GetThreadIndex());
+            epoch = current;
+        }
+        return rng;
+    }
+    
+    // Seeds every thread's generator (and Random()) for a reproducible
+    // run. Until then the seed comes from std::random_device.
+    static void SetGlobalSeed(uint64_t seed) {
+        globalSeed.store(seed);
+        globalEpoch.fetch_add(1, std::memory_order_release);
+    }
+    
+    static uint64_t GetGlobalSeed() { return globalSeed.load(); }
+    
+    // Bumped by every SetGlobalSeed, so long-lived generators can tell
+    // they need reseeding
+    static uint64_t GetGlobalEpoch() { return globalEpoch.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t LaneCount = 8;
+    
+    uint32_t state[4];
+    
+    // Eight generators for Fill, one per column
+    uint32_t lanes[4][LaneCount];
+    bool lanesSeeded = false;
+    
+    static uint64_t DrawSeed() {
+        std::random_device device;
+        return ((uint64_t)device() << 32) | device();
+    }
+    
+    static inline std::atomic<uint64_t> globalSeed{DrawSeed()};
+    static inline std::atomic<uint64_t> globalEpoch{1};  // Bumped on every SetGlobalSeed
+    
+    static uint64_t SplitMix(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+    static uint32_t Rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+    
+    static uint32_t Step(uint32_t& s0, uint32_t& s1, uint32_t& s2, uint32_t& s3) {
+        uint32_t result = Rotl(s1 * 5, 7) * 9;
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = Rotl(s3, 11);
+        return result;
+    }
+    
+    void SeedLanes() {
+        uint64_t mixer = ((uint64_t)Next() << 32) | Next();
+        for (size_t k = 0; k < LaneCount; k++) {
+            for (int word = 0; word < 4; word += 2) {
+                uint64_t value = SplitMix(mixer);
+                lanes[word][k] = (uint32_t)value;
+                lanes[word + 1][k] = (uint32_t)(value >> 32);
+            }
+        }
+        lanesSeeded = true;
+    }
+    
+    // Same steps as Next, column-wise across the lanes
+    void NextLanes(float* RAYGAME_RESTRICT out, float min, float scale) {
+        uint32_t* RAYGAME_RESTRICT s0 = lanes[0];
+        uint32_t* RAYGAME_RESTRICT s1 = lanes[1];
+        uint32_t* RAYGAME_RESTRICT s2 = lanes[2];
+        uint32_t* RAYGAME_RESTRICT s3 = lanes[3];
+        
+        for (size_t k = 0; k < LaneCount; k++) {
+            uint32_t result = Rotl(s1[k] * 5, 7) * 9;
+            uint32_t t = s1[k] << 9;
+            s2[k] ^= s0[k];
+            s3[k] ^= s1[k];
+            s1[k] ^= s2[k];
+            s0[k] ^= s3[k];
+            s2[k] ^= t;
+            s3[k] = Rotl(s3[k], 11);
+            out[k] = min + (float)(result >> 8) * scale;
+        }
+    }
+};
+
+// Convenience ranges on the calling thread's generator
+inline float Random(float min, float max) {
+    if (min >= max) return min;
+    return Rng::ThreadLocal().Range(min, max);
+}
+
+inline Vector2 Random(const Vector2& min, const Vector2& max) {
+    return { Random(min.x, max.x), Random(min.y, max.y) };
+}
+
+}
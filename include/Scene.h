@@ -2,6 +2,10 @@
 
 #include "Core.h"
 #include "GameObject.h"
+#include "ArchetypeStorage.h"
+#include "CommandBuffer.h"
+#include "ParticleRenderer.h"
+#include "ParticleSystemManager.h"
 #include "Camera2D.h"
 
 namespace RayGame {
@@ -13,45 +17,191 @@ public:
     Scene(const std::string& sceneName = "New Scene") 
         : name(sceneName), started(false) {}
     
-    virtual ~Scene() = default;
+    virtual ~Scene() {
+        // Objects kept alive by outside Refs must not call back into us
+        for (auto& obj : gameObjects) {
+            obj->scene = nullptr;
+        }
+    }
     
     virtual void OnLoad() {}
     virtual void OnUnload() {}
     virtual void Update() {
-        // Update all objects first (use index-based loop to avoid iterator invalidation)
-        for (size_t i = 0; i < gameObjects.size(); i++) {
-            if (gameObjects[i] && gameObjects[i]->active) {
-                gameObjects[i]->Update();
-            }
-        }
+        // Objects created after the scene started get Start before their first
+        // Update; inactive ones wait in the list until they are activated
+        StartPendingObjects();
         
-        // Remove inactive objects after all updates are done
-        gameObjects.erase(
-            std::remove_if(gameObjects.begin(), gameObjects.end(),
-                [](const Ref<GameObject>& obj) { return !obj || !obj->active; }),
-            gameObjects.end()
-        );
+        // Only component types that override Update, type by type through
+        // the archetype columns. Objects created meanwhile join afterwards.
+        PrepareCommandBuffers();
+        storage.Dispatch(ArchetypeStorage::Callback::Update, true);
+        
+        // Emitters scheduled themselves in Update, pooled effects join them;
+        // all of them simulate together on the job system. Runs before
+        // commands are applied, so no scheduled emitter has gone away yet.
+        particleSystems.Update();
+        ParticleSimulation::Run(GameTime::DeltaTime());
+        particleSystems.RecycleFinished();
+        
+        ApplyCommands();
+        
+        // Release objects destroyed this frame, after all updates are done.
+        // Indexed, since releasing a parent queues its children.
+        for (size_t i = 0; i < pendingRelease.size(); i++) {
+            ReleaseGameObject(slots[pendingRelease[i]].dense);
+        }
+        pendingRelease.clear();
+        RemoveReleased();
     }
     
+    // Runs at the engine's tick rate, possibly several times per frame
+    virtual void FixedUpdate() {
+        PrepareCommandBuffers();
+        storage.Dispatch(ArchetypeStorage::Callback::FixedUpdate, true);
+        ApplyCommands();
+    }
+    
+    // Object by object, in creation order; particles come last, in one
+    // batched pass.
     virtual void Render() {
+        UpdateTransforms();
         for (auto& obj : gameObjects) {
             obj->Render();
         }
+        particleSystems.Render();
+        ParticleRenderer::Flush();
+    }
+    
+    // Refreshes cached world transforms, root by root with parents before
+    // children. Render runs it once per frame, after updates and physics;
+    // Update and FixedUpdate refresh before each parallel stage.
+    void UpdateTransforms() {
+        storage.UpdateTransforms();
     }
     
+    // Takes a free slot and reuses its pooled object when nothing else holds it
     Ref<GameObject> CreateGameObject(const std::string& name = "GameObject") {
-        auto obj = CreateRef<GameObject>(name);
-        gameObjects.push_back(obj);
-        return obj;
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+        
+        EntitySlot& slot = slots[index];
+        if (slot.object && slot.object.use_count() == 1) {
+            slot.object->Reset(name);
+        } else {
+            slot.object = CreatePooledRef<GameObject>(name);
+        }
+        
+        GameObject* obj = slot.object.get();
+        obj->scene = this;
+        obj->handle = {index, slot.generation};
+        Link(nameMembers, obj->name, obj, &GameObject::nameSlot);
+        Link(tagMembers, obj->tag, obj, &GameObject::tagSlot);
+        
+        slot.dense = (uint32_t)gameObjects.size();
+        gameObjects.push_back(slot.object);
+        storage.Add(obj);
+        if (started) pendingStart.push_back(obj->handle);
+        return slot.object;
     }
     
-    void DestroyGameObject(Ref<GameObject> obj) {
-        auto it = std::find(gameObjects.begin(), gameObjects.end(), obj);
-        if (it != gameObjects.end()) {
-            gameObjects.erase(it);
+    // The handle goes stale at once; the object is deactivated and released
+    // at the end of the next Update, so it is safe to call from a component.
+    // Only destroyed objects are released: setting active to false just
+    // takes an object out of updates and rendering until it is reactivated.
+    void DestroyGameObject(EntityHandle handle) {
+        if (!IsValid(handle)) return;
+        
+        EntitySlot& slot = slots[handle.index];
+        slot.object->active = false;
+        slot.generation++;
+        pendingRelease.push_back(handle.index);
+    }
+    
+    void DestroyGameObject(const Ref<GameObject>& obj) {
+        if (obj) DestroyGameObject(obj->GetHandle());
+    }
+    
+    // Releases every object right away; don't call from inside Update
+    void DestroyAllGameObjects() {
+        while (!gameObjects.empty()) {
+            for (size_t i = gameObjects.size(); i-- > 0;) {
+                ReleaseGameObject(i);
+            }
+            RemoveReleased();  // Keeps any object created by OnDestroy
+        }
+        pendingRelease.clear();
+        pendingStart.clear();
+    }
+    
+    // The calling thread's buffer of deferred structural changes. Safe to
+    // record into from any update, including ones running on workers; the
+    // scene applies every buffer after its Update and FixedUpdate passes.
+    CommandBuffer& GetCommandBuffer() {
+        size_t thread = (size_t)JobSystem::GetThreadIndex();
+        if (thread >= commandBuffers.size()) {
+            commandBuffers.resize(thread + 1);  // Only off the pool's parallel passes
+        }
+        return commandBuffers[thread];
+    }
+    
+    // Applies recorded changes as one storage batch: every touched object
+    // moves archetype once, however many commands it got. Buffers play back
+    // in thread order, each in recording order, so the order across threads
+    // is only repeatable in the job system's deterministic mode. Commands on
+    // stale handles are dropped. Call from the main thread, outside passes.
+    void ApplyCommands() {
+        storage.BeginBatch();
+        
+        // Indexed, since a setup callback may record more commands
+        for (size_t b = 0; b < commandBuffers.size(); b++) {
+            for (size_t i = 0; i < commandBuffers[b].GetCommandCount(); i++) {
+                CommandBuffer::Command command = std::move(commandBuffers[b].commands[i]);
+                
+                switch (command.type) {
+                    case CommandBuffer::CommandType::Spawn: {
+                        Ref<GameObject> obj = CreateGameObject(command.name);
+                        if (command.fn) command.fn(*obj);
+                        break;
+                    }
+                    case CommandBuffer::CommandType::Destroy:
+                        DestroyGameObject(command.target);
+                        break;
+                    case CommandBuffer::CommandType::Modify:
+                        if (GameObject* obj = GetGameObject(command.target)) {
+                            command.fn(*obj);
+                        }
+                        break;
+                }
+            }
+            commandBuffers[b].Clear();
         }
+        
+        storage.EndBatch();
+    }
+    
+    bool IsValid(EntityHandle handle) const {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
     }
     
+    // Null for stale handles
+    GameObject* GetGameObject(EntityHandle handle) const {
+        return IsValid(handle) ? slots[handle.index].object.get() : nullptr;
+    }
+    
+    // Iterates active objects holding all of Ts (exact types) in place:
+    //     for (auto [obj, rb, collider] : View<Rigidbody, CircleCollider>()) { ... }
+    template<typename... Ts>
+    ComponentView<Ts...> View() {
+        return storage.View<Ts...>();
+    }
+    
+    // Allocates a result; prefer View in per-frame code
     template<typename T>
     std::vector<Ref<GameObject>> FindGameObjectsWithComponent() {
         std::vector<Ref<GameObject>> result;
@@ -63,23 +213,26 @@ public:
         return result;
     }
     
-    std::vector<Ref<GameObject>> FindGameObjectsByTag(const std::string& tag) {
+    // Objects carrying a tag, without copying; valid until objects are
+    // created, destroyed or retagged
+    const std::vector<GameObject*>& GetGameObjectsWithTag(StringId tag) const {
+        return Members(tagMembers, tag);
+    }
+    
+    std::vector<Ref<GameObject>> FindGameObjectsByTag(StringId tag) {
+        const auto& members = Members(tagMembers, tag);
+        
         std::vector<Ref<GameObject>> result;
-        for (auto& obj : gameObjects) {
-            if (obj->tag == tag) {
-                result.push_back(obj);
-            }
+        result.reserve(members.size());
+        for (GameObject* obj : members) {
+            result.push_back(slots[obj->handle.index].object);
         }
         return result;
     }
     
-    Ref<GameObject> FindGameObjectByName(const std::string& name) {
-        for (auto& obj : gameObjects) {
-            if (obj->name == name) {
-                return obj;
-            }
-        }
-        return nullptr;
+    Ref<GameObject> FindGameObjectByName(StringId name) {
+        const auto& members = Members(nameMembers, name);
+        return members.empty() ? nullptr : slots[members.front()->handle.index].object;
     }
     
     void Start() {
@@ -88,6 +241,7 @@ public:
                 obj->Start();
             }
             started = true;
+            pendingStart.clear();
         }
     }
     
@@ -95,9 +249,130 @@ public:
         return gameObjects;
     }
     
+    const ArchetypeStorage& GetStorage() const { return storage; }
+    
+    // Pooled one-shot effects, e.g. explosions
+    ParticleSystemManager& GetParticleSystems() { return particleSystems; }
+
 protected:
-    std::vector<Ref<GameObject>> gameObjects;
+    ArchetypeStorage storage;  // Declared first so it outlives gameObjects
+    std::vector<Ref<GameObject>> gameObjects;  // Live objects, dense
+    ParticleSystemManager particleSystems;
     bool started;
+
+private:
+    friend class GameObject;
+    
+    // Objects grouped by an interned key. Each object remembers its index
+    // in its list, so linking and unlinking are O(1).
+    using MemberLists = std::unordered_map<StringId, std::vector<GameObject*>>;
+    using MemberSlot = uint32_t GameObject::*;
+    
+    struct EntitySlot {
+        Ref<GameObject> object;    // Kept after release so the object can be reused
+        uint32_t generation = 0;   // Bumped when the object is destroyed
+        uint32_t dense = 0;        // Index into gameObjects while alive
+    };
+    
+    std::vector<EntitySlot> slots;
+    std::vector<uint32_t> freeSlots;
+    MemberLists nameMembers;
+    MemberLists tagMembers;
+    std::vector<CommandBuffer> commandBuffers;  // One per job system thread
+    std::vector<uint32_t> pendingRelease;       // Slots destroyed since the last Update
+    std::vector<EntityHandle> pendingStart;     // Created after Start, not started yet
+    
+    void StartPendingObjects() {
+        size_t kept = 0;
+        for (size_t i = 0; i < pendingStart.size(); i++) {
+            EntityHandle handle = pendingStart[i];
+            GameObject* obj = GetGameObject(handle);
+            if (!obj || obj->IsStarted()) continue;
+            
+            if (obj->active) {
+                obj->Start();  // May create objects, which append to the list
+            } else {
+                pendingStart[kept++] = handle;
+            }
+        }
+        pendingStart.resize(kept);
+    }
+    
+    // Sized up front, so workers never grow the vector mid-pass
+    void PrepareCommandBuffers() {
+        size_t threads = (size_t)JobSystem::GetThreadCount();
+        if (commandBuffers.size() < threads) commandBuffers.resize(threads);
+    }
+    
+    static const std::vector<GameObject*>& Members(const MemberLists& lists, StringId key) {
+        static const std::vector<GameObject*> none;
+        auto it = lists.find(key);
+        return it != lists.end() ? it->second : none;
+    }
+    
+    static void Link(MemberLists& lists, StringId key, GameObject* obj, MemberSlot slot) {
+        auto& members = lists[key];
+        obj->*slot = (uint32_t)members.size();
+        members.push_back(obj);
+    }
+    
+    // Swap-with-last; the list is kept even when it empties, for reuse
+    static void Unlink(MemberLists& lists, StringId key, GameObject* obj, MemberSlot slot) {
+        auto& members = lists[key];
+        uint32_t index = obj->*slot;
+        members[index] = members.back();
+        members[index]->*slot = index;
+        members.pop_back();
+    }
+    
+    // Called by GameObject::SetName / SetTag
+    void OnNameChanged(GameObject* obj, StringId name) {
+        Unlink(nameMembers, obj->name, obj, &GameObject::nameSlot);
+        obj->name = name;
+        Link(nameMembers, name, obj, &GameObject::nameSlot);
+    }
+    
+    void OnTagChanged(GameObject* obj, StringId tag) {
+        Unlink(tagMembers, obj->tag, obj, &GameObject::tagSlot);
+        obj->tag = tag;
+        Link(tagMembers, tag, obj, &GameObject::tagSlot);
+    }
+    
+    void ReleaseGameObject(size_t dense) {
+        Ref<GameObject> obj = gameObjects[dense];
+        EntityHandle handle = obj->GetHandle();
+        EntitySlot& slot = slots[handle.index];
+        if (slot.generation == handle.generation) slot.generation++;
+        
+        storage.Remove(obj.get());
+        Unlink(nameMembers, obj->name, obj.get(), &GameObject::nameSlot);
+        Unlink(tagMembers, obj->tag, obj.get(), &GameObject::tagSlot);
+        obj->scene = nullptr;
+        
+        // Children go with their parent, in the same release pass
+        for (Transform* child : obj->transform->GetChildren()) {
+            DestroyGameObject(child->GetGameObject()->GetHandle());
+        }
+        
+        obj->active = false;
+        obj->DestroyComponents();
+        freeSlots.push_back(handle.index);
+    }
+    
+    // Drops released objects from gameObjects in one pass. The rest keep
+    // their order, so draw order stays creation order.
+    void RemoveReleased() {
+        size_t kept = 0;
+        for (size_t i = 0; i < gameObjects.size(); i++) {
+            if (!gameObjects[i]->GetScene()) continue;
+            if (kept != i) {
+                gameObjects[kept] = std::move(gameObjects[i]);
+                slots[gameObjects[kept]->GetHandle().index].dense = (uint32_t)kept;
+            }
+            kept++;
+        }
+        gameObjects.resize(kept);
+    }
 };
 
 }
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Core.h"
+#include <cstdint>
+#include <limits>
+
+namespace RayGame {
+
+// Uniform grid broadphase keyed by hashed cell coordinates.
+// Entries are re-bucketed every step; only entries sharing a cell become
+// candidate pairs, so the cost grows with the number of entries rather than
+// with the number of possible pairs. Entries spanning more than
+// MaxCellsPerAxis cells on either axis (or with non-finite bounds) are kept
+// in a separate list and tested against every other entry instead.
+class RAYGAME_API SpatialHash {
+public:
+    SpatialHash(float cellSize = 64.0f) : cellSize(cellSize) {}
+    
+    void SetCellSize(float size) {
+        if (size <= 0) return;
+        cellSize = size;
+        cells.clear();
+        usedCells.clear();
+    }
+    
+    float GetCellSize() const { return cellSize; }
+    
+    // Empties all buckets but keeps their storage for the next step
+    void Clear() {
+        for (int64_t key : usedCells) {
+            cells[key].clear();
+        }
+        
+        // Buckets left behind by objects that moved away are dropped once
+        // they clearly outnumber the live ones
+        if (cells.size() > usedCells.size() * 4 + 1024) {
+            cells.clear();
+        }
+        
+        usedCells.clear();
+        bounds.clear();
+        oversized.clear();
+        isOversized.clear();
+    }
+    
+    // Ids must be dense and inserted in increasing order
+    void Insert(int id, const Rectangle& rect) {
+        if (id >= (int)bounds.size()) {
+            bounds.resize(id + 1);
+            isOversized.resize(id + 1, 0);
+        }
+        bounds[id] = rect;
+        
+        if (!FitsGrid(rect)) {
+            isOversized[id] = 1;
+            oversized.push_back(id);
+            return;
+        }
+        
+        int minX = CellCoord(rect.x);
+        int minY = CellCoord(rect.y);
+        int maxX = CellCoord(rect.x + rect.width);
+        int maxY = CellCoord(rect.y + rect.height);
+        
+        for (int y = minY; y <= maxY; y++) {
+            for (int x = minX; x <= maxX; x++) {
+                int64_t key = CellKey(x, y);
+                auto& bucket = cells[key];
+                if (bucket.empty()) {
+                    usedCells.push_back(key);
+                }
+                bucket.push_back(id);
+            }
+        }
+    }
+    
+    // Calls callback(a, b) once for every pair of entries whose bounds overlap
+    template<typename F>
+    void ForEachPair(F&& callback) const {
+        for (int64_t key : usedCells) {
+            const auto& bucket = cells.find(key)->second;
+            
+            for (size_t i = 0; i < bucket.size(); i++) {
+                const Rectangle& a = bounds[bucket[i]];
+                
+                for (size_t j = i + 1; j < bucket.size(); j++) {
+                    const Rectangle& b = bounds[bucket[j]];
+                    if (!Overlaps(a, b)) continue;
+                    
+                    // A pair sharing several cells is only reported from the
+                    // cell holding the top-left corner of their overlap
+                    int ownerX = CellCoord(std::max(a.x, b.x));
+                    int ownerY = CellCoord(std::max(a.y, b.y));
+                    if (CellKey(ownerX, ownerY) != key) continue;
+                    
+                    callback(bucket[i], bucket[j]);
+                }
+            }
+        }
+        
+        // Oversized entries against everything; a pair of two oversized
+        // entries is reported by the one inserted first
+        for (int a : oversized) {
+            for (int b = 0; b < (int)bounds.size(); b++) {
+                if (b == a || (isOversized[b] && b < a)) continue;
+                if (!Overlaps(bounds[a], bounds[b])) continue;
+                callback(std::min(a, b), std::max(a, b));
+            }
+        }
+    }
+    
+    size_t GetCellCount() const { return usedCells.size(); }
+    size_t GetOversizedCount() const { return oversized.size(); }
+    
+    // Entries covering more cells than this on either axis skip the grid
+    static constexpr int MaxCellsPerAxis = 16;
+
+private:
+    float cellSize;
+    std::unordered_map<int64_t, std::vector<int>> cells;
+    std::vector<int64_t> usedCells;  // In first-use order, keeps pair order stable
+    std::vector<Rectangle> bounds;
+    std::vector<int> oversized;          // Ids kept out of the grid
+    std::vector<uint8_t> isOversized;    // Per id, so pairs of them aren't reported twice
+    
+    // Also rejects NaN and infinite bounds, whose cell coordinates would
+    // overflow the int conversion
+    bool FitsGrid(const Rectangle& rect) const {
+        float spanX = std::floor((rect.x + rect.width) / cellSize) - std::floor(rect.x / cellSize);
+        float spanY = std::floor((rect.y + rect.height) / cellSize) - std::floor(rect.y / cellSize);
+        const float limit = (float)std::numeric_limits<int>::max() / 2;
+        return spanX >= 0 && spanX < MaxCellsPerAxis &&
+               spanY >= 0 && spanY < MaxCellsPerAxis &&
+               std::fabs(rect.x) < limit * cellSize && std::fabs(rect.y) < limit * cellSize;
+    }
+    
+    int CellCoord(float value) const {
+        return (int)std::floor(value / cellSize);
+    }
+    
+    static int64_t CellKey(int x, int y) {
+        return (int64_t)(((uint64_t)(uint32_t)x << 32) | (uint32_t)y);
+    }
+    
+    static bool Overlaps(const Rectangle& a, const Rectangle& b) {
+        return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+               a.y <= b.y + b.height && b.y <= a.y + a.height;
+    }
+};
+
+}
@@ -32,21 +32,23 @@ public:
         if (!texture || !gameObject) return;
         
         auto tf = gameObject->transform;
+        Vector2 position = tf->GetWorldPosition();
+        Vector2 scale = tf->GetWorldScale();
         
         Rectangle dest = {
-            tf->position.x,
-            tf->position.y,
-            sourceRect.width * tf->scale.x * (flipX ? -1 : 1),
-            sourceRect.height * tf->scale.y * (flipY ? -1 : 1)
+            position.x,
+            position.y,
+            sourceRect.width * scale.x * (flipX ? -1 : 1),
+            sourceRect.height * scale.y * (flipY ? -1 : 1)
         };
         
         Vector2 origin = {
-            sourceRect.width * pivot.x * tf->scale.x,
-            sourceRect.height * pivot.y * tf->scale.y
+            sourceRect.width * pivot.x * scale.x,
+            sourceRect.height * pivot.y * scale.y
         };
         
         DrawTexturePro(*texture, sourceRect, dest, origin, 
-                      tf->rotation, tint);
+                      tf->GetWorldRotation(), tint);
     }
     
     Vector2 GetSize() const {
@@ -123,21 +125,23 @@ public:
         
         auto tf = gameObject->transform;
         auto& frame = frames[currentFrame];
+        Vector2 position = tf->GetWorldPosition();
+        Vector2 scale = tf->GetWorldScale();
         
         Rectangle dest = {
-            tf->position.x,
-            tf->position.y,
-            frame.sourceRect.width * tf->scale.x * (flipX ? -1 : 1),
-            frame.sourceRect.height * tf->scale.y * (flipY ? -1 : 1)
+            position.x,
+            position.y,
+            frame.sourceRect.width * scale.x * (flipX ? -1 : 1),
+            frame.sourceRect.height * scale.y * (flipY ? -1 : 1)
         };
         
         Vector2 origin = {
-            frame.sourceRect.width * pivot.x * tf->scale.x,
-            frame.sourceRect.height * pivot.y * tf->scale.y
+            frame.sourceRect.width * pivot.x * scale.x,
+            frame.sourceRect.height * pivot.y * scale.y
         };
         
         DrawTexturePro(*spriteSheet, frame.sourceRect, dest, origin,
-                      tf->rotation, tint);
+                      tf->GetWorldRotation(), tint);
     }
 };
 
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Core.h"
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace RayGame {
+
+// Global table of interned strings. Each distinct string is stored once
+// and keeps its id for the lifetime of the program.
+class RAYGAME_API StringTable {
+public:
+    static uint32_t Intern(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (strings.empty()) strings.emplace_back();  // Id 0 is the empty string
+        if (text.empty()) return 0;
+        
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+        
+        uint32_t id = (uint32_t)strings.size();
+        strings.push_back(text);
+        ids.emplace(text, id);
+        return id;
+    }
+    
+    // References stay valid; strings are never removed or moved
+    static const std::string& Get(uint32_t id) {
+        static const std::string empty;
+        std::lock_guard<std::mutex> lock(mutex);
+        return id < strings.size() ? strings[id] : empty;
+    }
+    
+    static size_t Count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return strings.size();
+    }
+
+private:
+    static inline std::mutex mutex;
+    static inline std::deque<std::string> strings;
+    static inline std::unordered_map<std::string, uint32_t> ids;
+};
+
+// Interned string handle; comparing and hashing cost an integer compare
+class RAYGAME_API StringId {
+public:
+    StringId() : id(0) {}
+    StringId(const std::string& text) : id(StringTable::Intern(text)) {}
+    StringId(const char* text) : id(text ? StringTable::Intern(text) : 0) {}
+    
+    uint32_t GetId() const { return id; }
+    bool IsEmpty() const { return id == 0; }
+    
+    const std::string& str() const { return StringTable::Get(id); }
+    const char* c_str() const { return str().c_str(); }
+    
+    bool operator==(StringId other) const { return id == other.id; }
+    bool operator!=(StringId other) const { return id != other.id; }
+    bool operator<(StringId other) const { return id < other.id; }
+
+private:
+    uint32_t id;
+};
+
+}
+
+namespace std {
+    template<>
+    struct hash<RayGame::StringId> {
+        size_t operator()(RayGame::StringId value) const noexcept {
+            return std::hash<uint32_t>()(value.GetId());
+        }
+    };
+}
@@ -13,12 +13,24 @@ public:
     }
     
     static float DeltaTime() { return deltaTime; }
+    
+    // Overrides the frame time until the next Update, for headless runs
+    // that step the scene themselves
+    static void SetDeltaTime(float value) { deltaTime = value; }
+    
+    // Length of one physics tick; FixedUpdate and PhysicsWorld::Step use it
+    static float FixedDeltaTime() { return fixedDeltaTime; }
+    static void SetFixedDeltaTime(float value) {
+        if (value > 0) fixedDeltaTime = value;
+    }
+    
     static float GetTime() { return time; }
     static int GetFrameCount() { return frameCount; }
     static float FPS() { return GetFPS(); }
     
 private:
     static inline float deltaTime = 0.0f;
+    static inline float fixedDeltaTime = 1.0f / 60.0f;
     static inline float time = 0.0f;
     static inline int frameCount = 0;
 };
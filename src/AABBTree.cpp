@@ -0,0 +1,8 @@
+#include "AABBTree.h"
+
+namespace RayGame {
+
+// DynamicAABBTree implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "ArchetypeStorage.h"
+
+namespace RayGame {
+
+// ArchetypeStorage implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "BodyStorage.h"
+
+namespace RayGame {
+
+// BodyStorage implementation - static inline members remain in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "CommandBuffer.h"
+
+namespace RayGame {
+
+// CommandBuffer implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "ComponentType.h"
+
+namespace RayGame {
+
+// ComponentType implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
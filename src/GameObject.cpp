@@ -1,9 +1,31 @@
 #include "GameObject.h"
+#include "ArchetypeStorage.h"
+#include "Scene.h"
 
 namespace RayGame {
 
 // GameObject implementation - template methods must stay in header
-// This file exists for future non-template implementations if needed
 
-} // namespace RayGame
+void GameObject::OnComponentsChanged() {
+    if (storage) storage->Refresh(this);
+}
+
+void GameObject::LeaveStorage() {
+    if (storage) storage->Remove(this);
+}
+
+void GameObject::SetName(StringId value) {
+    if (value == name) return;
+    
+    if (scene) scene->OnNameChanged(this, value);
+    else name = value;
+}
 
+void GameObject::SetTag(StringId value) {
+    if (value == tag) return;
+    
+    if (scene) scene->OnTagChanged(this, value);
+    else tag = value;
+}
+
+} // namespace RayGame
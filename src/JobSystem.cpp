@@ -0,0 +1,8 @@
+#include "JobSystem.h"
+
+namespace RayGame {
+
+// JobSystem implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "ParticleBuffer.h"
+
+namespace RayGame {
+
+// ParticleBuffer implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
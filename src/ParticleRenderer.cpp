@@ -0,0 +1,8 @@
+#include "ParticleRenderer.h"
+
+namespace RayGame {
+
+// ParticleRenderer implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "ParticleSystemManager.h"
+
+namespace RayGame {
+
+// ParticleSystemManager implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "PoolAllocator.h"
+
+namespace RayGame {
+
+// PoolAllocator implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "Rng.h"
+
+namespace RayGame {
+
+// Rng implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "SpatialHash.h"
+
+namespace RayGame {
+
+// SpatialHash implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -0,0 +1,8 @@
+#include "StringId.h"
+
+namespace RayGame {
+
+// StringId implementation - methods are already inline in header
+// This file exists for linking the DLL
+
+} // namespace RayGame
@@ -67,3 +67,15 @@ target("bouncing_balls")
             os.cp("assets", path.join(target:targetdir(), "assets"))
         end
     end)
+
+-- Headless determinism/stress check for the job system (no window or assets)
+target("stress_check")
+    set_kind("binary")
+    set_languages("c++17")
+    set_basename("stress_check")
+    
+    add_files("examples/stress_check/main.cpp")
+    add_deps("raygame")
+    
+    -- Set output directory
+    set_targetdir("$(projectdir)/bin")